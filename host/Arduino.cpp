@@ -0,0 +1,67 @@
+#include <chrono>
+#include <thread>
+
+#include "Arduino.h"
+
+HardwareSerial Serial;
+
+unsigned long millis() {
+    using namespace std::chrono;
+    static steady_clock::time_point start = steady_clock::now();
+    return duration_cast<milliseconds>(steady_clock::now() - start).count();
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+int Stream::timedRead() {
+    unsigned long start = millis();
+    do {
+        int c = read();
+        if (c >= 0) return c;
+    } while (millis() - start < _timeout);
+    return -1;
+}
+
+size_t Stream::readBytes(char *buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+        int c = timedRead();
+        if (c < 0) break;
+        buffer[count++] = (char)c;
+    }
+    return count;
+}
+
+String Stream::readStringUntil(char terminator) {
+    std::string line;
+    int c = timedRead();
+    while (c >= 0 && c != terminator) {
+        line += (char)c;
+        c = timedRead();
+    }
+    return String(line);
+}
+
+String::String(long number, int base) {
+    char str[34];
+    if (base == 16) {
+        snprintf(str, sizeof(str), "%lx", number);
+    } else {
+        snprintf(str, sizeof(str), "%ld", number);
+    }
+    value = str;
+}
+
+String::String(unsigned long number, int base) {
+    char str[34];
+    snprintf(str, sizeof(str), base == 16 ? "%lx" : "%lu", number);
+    value = str;
+}
+
+String::String(double number, int decimals) {
+    char str[34];
+    snprintf(str, sizeof(str), "%.*f", decimals, number);
+    value = str;
+}
@@ -0,0 +1,96 @@
+/*
+ * Host stand-in for the parts of the Arduino core used by the rendering code
+ * (String, Serial, PROGMEM, Stream), see render.cpp. Not used on the device.
+ */
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <string>
+
+#define DEC 10
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const unsigned char *)(addr))
+#define F(str) (str)
+
+unsigned long millis();
+void delay(unsigned long ms);
+
+class String {
+    std::string value;
+
+    public:
+        String(const char *str = "") : value(str) {};
+        String(const std::string &str) : value(str) {};
+        String(char c) : value(1, c) {};
+        String(unsigned char number, int base = DEC) : String((unsigned long)number, base) {};
+        String(int number, int base = DEC) : String((long)number, base) {};
+        String(unsigned int number, int base = DEC) : String((unsigned long)number, base) {};
+        String(long number, int base = DEC);
+        String(unsigned long number, int base = DEC);
+        String(float number, int decimals = 2) : String((double)number, decimals) {};
+        String(double number, int decimals = 2);
+
+        const char *c_str() const { return value.c_str(); }
+        unsigned int length() const { return value.length(); }
+
+        String &operator+=(const String &other) { value += other.value; return *this; }
+        friend String operator+(const String &a, const String &b) { return String(a.value + b.value); }
+        friend String operator+(const String &a, const char *b) { return String(a.value + b); }
+        bool operator==(const char *other) const { return value == other; }
+};
+
+class Print {
+    public:
+        virtual size_t write(uint8_t c) = 0;
+        virtual size_t write(const uint8_t *buffer, size_t size) {
+            size_t n = 0;
+            while (size--) n += write(*buffer++);
+            return n;
+        }
+        virtual ~Print() {};
+};
+
+// same reading behaviour as the core: readBytes waits up to the timeout for every byte
+class Stream : public Print {
+    protected:
+        unsigned long _timeout = 1000;
+        int timedRead();
+
+    public:
+        virtual int available() = 0;
+        virtual int read() = 0;
+        virtual int peek() = 0;
+        virtual void flush() {};
+
+        void setTimeout(unsigned long timeout) { _timeout = timeout; }
+        virtual size_t readBytes(char *buffer, size_t length);
+        size_t readBytes(uint8_t *buffer, size_t length) { return readBytes((char *)buffer, length); }
+        String readStringUntil(char terminator);
+};
+
+class HardwareSerial {
+    public:
+        void begin(unsigned long baud) {};
+        void print(const char *str) { fputs(str, stderr); }
+        void print(const String &str) { print(str.c_str()); }
+        void print(long number) { fprintf(stderr, "%ld", number); }
+        void print(int number) { print((long)number); }
+        void print(unsigned int number) { fprintf(stderr, "%u", number); }
+        void print(unsigned long number) { fprintf(stderr, "%lu", number); }
+        void print(double number, int decimals = 2) { fprintf(stderr, "%.*f", decimals, number); }
+        template <typename T>
+        void println(T value) { print(value); println(); }
+        void println() { fputs("\n", stderr); }
+};
+
+// log goes to stderr, stdout is the frame
+extern HardwareSerial Serial;
+
+#endif /* Arduino_h */
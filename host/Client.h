@@ -0,0 +1,31 @@
+#ifndef Client_h
+#define Client_h
+
+#include "Arduino.h"
+
+class IPAddress {
+    uint8_t address[4] = {0};
+
+    public:
+        IPAddress() {};
+        IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : address{a, b, c, d} {};
+};
+
+// network client interface of the Arduino core
+class Client : public Stream {
+    public:
+        virtual int connect(IPAddress ip, uint16_t port) = 0;
+        virtual int connect(const char *host, uint16_t port) = 0;
+        virtual size_t write(uint8_t c) = 0;
+        virtual size_t write(const uint8_t *buffer, size_t size) = 0;
+        virtual int available() = 0;
+        virtual int read() = 0;
+        virtual int read(uint8_t *buffer, size_t size) = 0;
+        virtual int peek() = 0;
+        virtual void flush() = 0;
+        virtual void stop() = 0;
+        virtual uint8_t connected() = 0;
+        virtual operator bool() = 0;
+};
+
+#endif /* Client_h */
@@ -0,0 +1,141 @@
+/**
+ *  @filename   :   civiltime_test.cpp
+ *  @brief      :   Checks Civil::utcOffset, local and floorLocal against the C
+ *                  library (localtime_r with the same POSIX TZ) in the days
+ *                  around each DST change, and a few floors across a change
+ *                  worked out by hand. Prints the failures, exits with 1 if any.
+ *
+ *      ./civiltime_test
+ *
+ *  Build on the host from the repository root:
+ *      g++ -O2 -Iinclude host/civiltime_test.cpp src/civiltime.cpp -o civiltime_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "civiltime.h"
+
+#define STEP_3H (3 * 3600)
+
+static int failures = 0;
+
+// zones where a floor to an hour, 3 hours or a day never lands in a skipped local time
+static const char *zones[] = {
+    "CET-1CEST,M3.5.0,M10.5.0/3",
+    "GMT0BST,M3.5.0/1,M10.5.0",
+    "EST5EDT,M3.2.0,M11.1.0",
+    "AEST-10AEDT,M10.1.0,M4.1.0/3",
+    "NZST-12NZDT,M9.5.0,M4.1.0/3",
+    "<+0530>-5:30",
+};
+
+static const int32_t floors[] = {3600, STEP_3H, SECONDS_PER_DAY};
+
+static time_t utcTime(int year, int month, int day, int hour, int minute)
+{
+    return static_cast<time_t>(Civil::daysFromCivil(year, month, day)) * SECONDS_PER_DAY + hour * 3600 + minute * 60;
+}
+
+static void check(const char *what, const char *tz, time_t utc, long long value, long long expected)
+{
+    if (value == expected) return;
+
+    failures++;
+    printf("%s %s at %lld: %lld, expected %lld\n", what, tz, static_cast<long long>(utc), value, expected);
+}
+
+// latest instant not after utc whose local time is a multiple of seconds, 15 minute steps
+static time_t referenceFloor(time_t utc, int32_t seconds)
+{
+    struct tm tm;
+    for (time_t t = utc - (utc % 900 + 900) % 900; ; t -= 900) {
+        localtime_r(&t, &tm);
+        long local = tm.tm_hour * 3600L + tm.tm_min * 60L + tm.tm_sec;
+        if (local % seconds == 0) return t;
+    }
+}
+
+static void checkAround(const char *tz, time_t from, time_t to)
+{
+    struct tm tm;
+    for (time_t utc = from; utc < to; utc += 600 + 7) {
+        localtime_r(&utc, &tm);
+        check("utcOffset", tz, utc, Civil::utcOffset(utc), tm.tm_gmtoff);
+
+        Civil::DateTime dt = Civil::local(utc);
+        check("local hour", tz, utc, dt.hour, tm.tm_hour);
+        check("local day", tz, utc, dt.day, tm.tm_mday);
+
+        for (unsigned int i = 0; i < sizeof(floors) / sizeof(floors[0]); i++) {
+            check("floorLocal", tz, utc, Civil::floorLocal(utc, floors[i]), referenceFloor(utc, floors[i]));
+        }
+    }
+}
+
+static void checkZone(const char *tz)
+{
+    setenv("TZ", tz, 1);
+    tzset();
+    if (!Civil::setZone(tz)) {
+        failures++;
+        printf("setZone %s failed\n", tz);
+        return;
+    }
+
+    // two days on both sides of every change (the offset differs from the hour before)
+    for (int year = 1999; year <= 2038; year++) {
+        time_t begin = utcTime(year, 1, 1, 0, 0);
+        time_t end = utcTime(year + 1, 1, 1, 0, 0);
+        int32_t offset = Civil::utcOffset(begin);
+        for (time_t t = begin; t < end; t += 3600) {
+            int32_t next = Civil::utcOffset(t);
+            if (next != offset) {
+                checkAround(tz, t - 2 * SECONDS_PER_DAY, t + 2 * SECONDS_PER_DAY);
+                offset = next;
+            }
+        }
+        // and some time away from them
+        checkAround(tz, utcTime(year, 6, 1, 0, 0), utcTime(year, 6, 3, 0, 0));
+    }
+}
+
+static void checkFloor(const char *tz, time_t utc, int32_t seconds, time_t expected)
+{
+    Civil::setZone(tz);
+    check("floorLocal", tz, utc, Civil::floorLocal(utc, seconds), expected);
+}
+
+int main()
+{
+    for (unsigned int i = 0; i < sizeof(zones) / sizeof(zones[0]); i++) {
+        checkZone(zones[i]);
+    }
+
+    const char *cet = "CET-1CEST,M3.5.0,M10.5.0/3";
+    // 02:28 CET after the change back, 00:00 local was still CEST
+    checkFloor(cet, utcTime(2000, 10, 29, 1, 28), STEP_3H, utcTime(2000, 10, 28, 22, 0));
+    checkFloor(cet, utcTime(2000, 10, 29, 1, 28), SECONDS_PER_DAY, utcTime(2000, 10, 28, 22, 0));
+    // 02:28 CEST before it, the repeated hour
+    checkFloor(cet, utcTime(2000, 10, 29, 0, 28), 3600, utcTime(2000, 10, 29, 0, 0));
+    // 03:30 CEST after the change forward, midnight was CET
+    checkFloor(cet, utcTime(2000, 3, 26, 1, 30), STEP_3H, utcTime(2000, 3, 26, 1, 0));
+    checkFloor(cet, utcTime(2000, 3, 26, 10, 0), SECONDS_PER_DAY, utcTime(2000, 3, 25, 23, 0));
+    // 02:00 local does not exist, the floor is the change at 03:00 CEST
+    checkFloor(cet, utcTime(2000, 3, 26, 1, 30), 2 * 3600, utcTime(2000, 3, 26, 1, 0));
+
+    // southern hemisphere, 02:30 AEST after the change back and 03:30 AEDT after the change forward
+    const char *aest = "AEST-10AEDT,M10.1.0,M4.1.0/3";
+    checkFloor(aest, utcTime(2021, 4, 3, 16, 30), STEP_3H, utcTime(2021, 4, 3, 13, 0));
+    checkFloor(aest, utcTime(2021, 10, 2, 16, 30), STEP_3H, utcTime(2021, 10, 2, 16, 0));
+
+    // the day starts at 01:00 when the change is at midnight
+    const char *chile = "<-04>4<-03>,M9.1.6/24,M4.1.6/24";
+    checkFloor(chile, utcTime(2021, 9, 5, 13, 0), SECONDS_PER_DAY, utcTime(2021, 9, 5, 4, 0));
+
+    if (failures == 0) {
+        printf("civiltime: all checks passed\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+/**
+ *  @filename   :   render.cpp
+ *  @brief      :   Renders the station layout on the host with the same Display
+ *                  code as the device (against the EPD recorder) and writes the
+ *                  compressed frame (frame.h) to stdout, for thin clients
+ *                  (USE_THIN_CLIENT). The weather is read from stdin in the
+ *                  wire format of resources/weather_proxy.py:
+ *
+ *      ./render <time> <TZ> [frame.pbm] < weather.bin > frame.wxf
+ *
+ *  time 0 is now, TZ is a POSIX time zone (e.g. "CET-1CEST,M3.5.0,M10.5.0/3").
+ *
+ *  Build on the host (no Arduino framework) from the repository root:
+ *      g++ -O2 -DWEATHER_JSON=0 -Ihost -Iinclude -Ilib/epd/src host/render.cpp host/Arduino.cpp src/display.cpp src/weather.cpp src/civiltime.cpp src/refresh.cpp src/frame.cpp lib/epd/src/epd4in2.cpp lib/epd/src/epdpaint.cpp lib/epd/src/epdif_linux.cpp lib/epd/src/epdrecorder.cpp -o render
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "display.h"
+#include "weather.h"
+#include "civiltime.h"
+#include "frame.h"
+#include "epdrecorder.h"
+
+static_assert(DisplayPanel::bits_per_pixel == 1 && DisplayPanel::planes == 1, "frames are 1 bit black / white");
+
+// PackBits grows incompressible data by one byte in 128
+static uint8_t frame[FRAME_HEADER_SIZE + DisplayPanel::plane_size + DisplayPanel::plane_size / 128 + 1];
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <time> <TZ> [frame.pbm] < weather.bin > frame.wxf\n", argv[0]);
+        return 2;
+    }
+
+    time_t now = atoll(argv[1]);
+    if (now == 0) {
+        now = time(NULL);
+    }
+    if (!Civil::setZone(argv[2])) {
+        fprintf(stderr, "invalid TZ %s\n", argv[2]);
+        return 2;
+    }
+
+    uint8_t data[WIRE_MAX_SIZE];
+    size_t length = fread(data, 1, sizeof(data), stdin);
+
+    Weather weather = {0};
+    if (!WeatherAPI::decodeWeather(data, length, &weather, Display::horizon, now)) {
+        fprintf(stderr, "invalid weather (%zu bytes)\n", length);
+        return 1;
+    }
+
+    // same as setup() on the device
+    Civil::DateTime current = Civil::local(now);
+    int rounded_hour = current.hour + (int)roundf((float)current.minute / 60);
+    time_t rounded_time = Civil::floorLocal(now + 1800, 3600); // nearest hour
+    int offset_hour = (rounded_time - weather.start) / 3600;
+
+    RenderState state = {.valid = true, .current_hour = rounded_hour, .offset_hour = offset_hour, .error = UpdateError::ENone, .weather = weather};
+    RenderState shown = {0};
+    uint8_t partial_count = 0;
+    RefreshPolicy policy(partial_count);
+
+    Display *display = new Display();
+    if (!display->initialize(true)) {
+        return 1;
+    }
+    display->draw(state, shown, policy);
+    delete display;
+
+    // the recorder keeps what the panel shows
+    length = encodeFrame(epd_recorder.image, DisplayPanel::width, DisplayPanel::height, frame, sizeof(frame));
+    fwrite(frame, 1, length, stdout);
+    fprintf(stderr, "frame %zu bytes\n", length);
+
+    if (argc > 3) {
+        epd_recorder.WritePbm(argv[3]);
+    }
+    return 0;
+}
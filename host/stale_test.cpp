@@ -0,0 +1,113 @@
+/**
+ *  @filename   :   stale_test.cpp
+ *  @brief      :   Checks that weather kept after an answer 304 renders the same
+ *                  frame as a fresh response. The weather (wire format, see
+ *                  resources/weather_proxy.py --encode) is decoded at time as
+ *                  setup() does, then rendered 0 - NOT_MODIFIED_HOURS hours
+ *                  later and compared with the frame of the same response
+ *                  decoded at that later time. Exits with 1 on a difference.
+ *
+ *      ./stale_test <time> <TZ> [frame.pbm] < weather.bin
+ *
+ *  The first differing stale frame is written to frame.pbm.
+ *
+ *  Build on the host (no Arduino framework) from the repository root:
+ *      g++ -O2 -DWEATHER_JSON=0 -Ihost -Iinclude -Ilib/epd/src host/stale_test.cpp host/Arduino.cpp src/display.cpp src/weather.cpp src/civiltime.cpp src/refresh.cpp src/frame.cpp lib/epd/src/epd4in2.cpp lib/epd/src/epdpaint.cpp lib/epd/src/epdif_linux.cpp lib/epd/src/epdrecorder.cpp -o stale_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "display.h"
+#include "weather.h"
+#include "civiltime.h"
+#include "epdrecorder.h"
+
+#define NOT_MODIFIED_HOURS 9 // same as src/main.cpp
+
+static uint8_t data[WIRE_MAX_SIZE];
+static size_t length;
+
+static unsigned char fresh[Panel4in2::plane_size];
+
+// what setup() parses from a response at current_time
+static bool decode(time_t current_time, Weather *weather)
+{
+    Horizon horizon = {
+        (uint8_t)(Display::horizon.hours + NOT_MODIFIED_HOURS),
+        (uint8_t)(Display::horizon.hours_10min + NOT_MODIFIED_HOURS),
+        (uint8_t)(Display::horizon.days + 1)
+    };
+    memset(weather, 0, sizeof(*weather));
+    return WeatherAPI::decodeWeather(data, length, weather, horizon, current_time);
+}
+
+// full refresh of weather at current_time, same as setup() on the device
+static void render(const Weather &weather, time_t current_time)
+{
+    Civil::DateTime current = Civil::local(current_time);
+    int rounded_hour = current.hour + (int)roundf((float)current.minute / 60);
+    time_t rounded_time = Civil::floorLocal(current_time + 1800, 3600); // nearest hour
+    int offset_hour = (rounded_time - weather.start) / 3600;
+
+    RenderState state = {.valid = true, .current_hour = rounded_hour, .offset_hour = offset_hour, .error = UpdateError::ENone, .weather = weather};
+    RenderState shown = {0};
+    uint8_t partial_count = 0;
+    RefreshPolicy policy(partial_count);
+
+    Display *display = new Display();
+    display->initialize(true);
+    display->draw(state, shown, policy);
+    delete display;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <time> <TZ> [frame.pbm] < weather.bin\n", argv[0]);
+        return 2;
+    }
+
+    time_t now = atoll(argv[1]);
+    if (!Civil::setZone(argv[2])) {
+        fprintf(stderr, "invalid TZ %s\n", argv[2]);
+        return 2;
+    }
+    length = fread(data, 1, sizeof(data), stdin);
+
+    Weather saved;
+    if (!decode(now, &saved)) {
+        fprintf(stderr, "invalid weather (%zu bytes)\n", length);
+        return 2;
+    }
+
+    int failures = 0;
+    for (int hours = 0; hours <= NOT_MODIFIED_HOURS; hours++) {
+        time_t later = now + hours * 3600;
+
+        Weather weather;
+        decode(later, &weather);
+        render(weather, later);
+        memcpy(fresh, epd_recorder.image, sizeof(fresh));
+
+        // main.cpp only keeps the data after a 304 if it still fills the layout
+        if (!Display::covers(saved, later)) {
+            printf("+%dh: saved weather does not cover the layout, full request\n", hours);
+            continue;
+        }
+
+        render(saved, later);
+        int diff = 0;
+        for (size_t i = 0; i < sizeof(fresh); i++) {
+            diff += __builtin_popcount(fresh[i] ^ epd_recorder.image[i]);
+        }
+        printf("+%dh: %s", hours, diff == 0 ? "same frame\n" : "");
+        if (diff != 0) {
+            printf("%d pixels differ\n", diff);
+            if (failures++ == 0 && argc > 3) {
+                epd_recorder.WritePbm(argv[3]);
+            }
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
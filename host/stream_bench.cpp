@@ -0,0 +1,147 @@
+/**
+ *  @filename   :   stream_bench.cpp
+ *  @brief      :   Counts what reading a response costs the TLS client, read byte
+ *                  by byte like ArduinoJson (readBytes(&c, 1)) and in chunks like
+ *                  WeatherParser, straight from the client and through
+ *                  BufferedStream. The client follows WiFiClientSecure of the
+ *                  ESP32 core: available() is an mbedtls_ssl_read(NULL, 0) plus
+ *                  mbedtls_ssl_get_bytes_avail, read(&c, 1) checks available()
+ *                  first and then reads the single byte.
+ *
+ *      ./stream_bench [response] [record size]
+ *
+ *  Build on the host from the repository root:
+ *      g++ -O2 -Ihost -Iinclude host/stream_bench.cpp host/Arduino.cpp src/bufferedstream.cpp -o stream_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <chrono>
+
+#include "bufferedstream.h"
+
+class TlsClientModel : public Client {
+    const std::vector<uint8_t> &data;
+    size_t position = 0;
+    size_t record_size;
+    size_t record_left = 0; // decrypted bytes of the current record
+
+    // mbedtls_ssl_read, a new record is decrypted once the last one is used up
+    int sslRead(uint8_t *buffer, size_t size) {
+        ssl_reads++;
+        if (record_left == 0) {
+            record_left = data.size() - position < record_size ? data.size() - position : record_size;
+            if (record_left > 0) records++;
+        }
+        size_t n = size < record_left ? size : record_left;
+        if (buffer != nullptr) {
+            memcpy(buffer, data.data() + position, n);
+            position += n;
+            record_left -= n;
+        }
+        return n;
+    }
+
+    public:
+        unsigned long ssl_reads = 0;
+        unsigned long records = 0;
+
+        TlsClientModel(const std::vector<uint8_t> &data, size_t record_size) : data(data), record_size(record_size) {};
+
+        int available() {
+            sslRead(nullptr, 0);
+            return record_left > 0 ? record_left : data.size() - position;
+        }
+        int read() {
+            uint8_t c;
+            int n = read(&c, 1);
+            return n < 0 ? n : c;
+        }
+        int read(uint8_t *buffer, size_t size) {
+            if (available() <= 0) return -1;
+            return sslRead(buffer, size);
+        }
+        int peek() { return -1; }
+        uint8_t connected() { return position < data.size(); }
+
+        int connect(IPAddress ip, uint16_t port) { return 1; }
+        int connect(const char *host, uint16_t port) { return 1; }
+        size_t write(uint8_t c) { return 1; }
+        size_t write(const uint8_t *buffer, size_t size) { return size; }
+        void flush() {};
+        void stop() {};
+        operator bool() { return true; }
+};
+
+// returns a checksum so the reads are not optimized away
+static unsigned long readBytewise(Stream &stream) {
+    unsigned long sum = 0;
+    char c;
+    while (stream.readBytes(&c, 1) == 1) sum += (uint8_t)c;
+    return sum;
+}
+
+static unsigned long readChunks(Client &client) {
+    unsigned long sum = 0;
+    uint8_t chunk[64];
+    while (client.connected() && client.available() > 0) {
+        int n = client.read(chunk, sizeof(chunk));
+        for (int i = 0; i < n; i++) sum += chunk[i];
+    }
+    return sum;
+}
+
+static void report(const char *name, unsigned long bytes, unsigned long calls, const TlsClientModel &tls, double ms) {
+    printf("%-22s bytes %6lu  reads %6lu  mbedtls_ssl_read %6lu  records %3lu  host %.3f ms\n",
+        name, bytes, calls, tls.ssl_reads, tls.records, ms);
+}
+
+template <typename F>
+static double timed(F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+    const char *path = argc > 1 ? argv[1] : "resources/sample_response.json";
+    size_t record_size = argc > 2 ? atoi(argv[2]) : 16384;
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "can not open %s\n", path);
+        return 1;
+    }
+    std::vector<uint8_t> data;
+    int c;
+    while ((c = fgetc(f)) != EOF) data.push_back(c);
+    fclose(f);
+
+    printf("%s: %zu bytes in TLS records of %zu bytes\n", path, data.size(), record_size);
+
+    {
+        TlsClientModel tls(data, record_size);
+        tls.setTimeout(0);
+        double ms = timed([&] { readBytewise(tls); });
+        report("bytewise, client", data.size(), data.size() + 1, tls, ms);
+    }
+    {
+        TlsClientModel tls(data, record_size);
+        BufferedStream stream(tls);
+        double ms = timed([&] { readBytewise(stream); });
+        report("bytewise, buffered", stream.bytes, stream.calls, tls, ms);
+    }
+    {
+        TlsClientModel tls(data, record_size);
+        double ms = timed([&] { readChunks(tls); });
+        report("64 B chunks, client", data.size(), (data.size() + 63) / 64, tls, ms);
+    }
+    {
+        TlsClientModel tls(data, record_size);
+        BufferedStream stream(tls);
+        double ms = timed([&] { readChunks(stream); });
+        report("64 B chunks, buffered", stream.bytes, stream.calls, tls, ms);
+    }
+    return 0;
+}
@@ -0,0 +1,149 @@
+/**
+ *  @filename   :   wire_test.cpp
+ *  @brief      :   Checks that the wire format decodes to the same Weather as the
+ *                  JSON response it was encoded from. The response is parsed with
+ *                  WeatherAPI::parseWeather (ArduinoJson, as main.cpp) and with
+ *                  WeatherParser, the wire data (resources/weather_proxy.py
+ *                  --encode) with WeatherAPI::decodeWeather, all at the same time
+ *                  and time zone. Prints the differences, exits with 1 if any.
+ *
+ *      python3 resources/weather_proxy.py --encode resources/sample_response.json --now <time> > weather.bin
+ *      ./wire_test <time> <TZ> resources/sample_response.json < weather.bin
+ *
+ *  Build on the host from the repository root, with ArduinoJson from the
+ *  PlatformIO libraries (pio pkg install):
+ *      g++ -O2 -Ihost -Iinclude -I.pio/libdeps/esp32thing/ArduinoJson/src host/wire_test.cpp host/Arduino.cpp src/weather.cpp src/weatherparser.cpp src/civiltime.cpp -o wire_test
+ *  or without it, WeatherParser only:
+ *      g++ -O2 -DWEATHER_JSON=0 -Ihost -Iinclude host/wire_test.cpp host/Arduino.cpp src/weather.cpp src/weatherparser.cpp src/civiltime.cpp -o wire_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "weather.h"
+#include "weatherparser.h"
+#include "civiltime.h"
+
+// everything Weather can hold
+static const Horizon horizon = {MAX_1H, MAX_10MIN / 6, MAX_FORECASTS};
+
+static int failures = 0;
+
+static void check(const char *parser, const char *what, int index, long long value, long long expected)
+{
+    if (value == expected) return;
+
+    failures++;
+    if (index < 0) {
+        printf("%s %s: %lld, wire %lld\n", parser, what, value, expected);
+    } else {
+        printf("%s %s[%d]: %lld, wire %lld\n", parser, what, index, value, expected);
+    }
+}
+
+template <typename T, int CAPACITY>
+static void checkSeries(const char *parser, const char *what, const Series<T, CAPACITY> &series, const Series<T, CAPACITY> &wire)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%s.start", what);
+    check(parser, name, -1, series.start, wire.start);
+    snprintf(name, sizeof(name), "%s.length", what);
+    check(parser, name, -1, series.length, wire.length);
+    for (int i = 0; i < series.length && i < wire.length; i++) {
+        check(parser, what, i, series[i], wire[i]);
+    }
+}
+
+static void compare(const char *parser, const Weather &weather, const Weather &wire)
+{
+    check(parser, "start", -1, weather.start, wire.start);
+    check(parser, "current.time", -1, weather.current.time, wire.current.time);
+    check(parser, "current.icon", -1, weather.current.icon, wire.current.icon);
+    check(parser, "current.temperature", -1, weather.current.temperature_value, wire.current.temperature_value);
+
+    check(parser, "forecasts.start", -1, weather.forecasts.start, wire.forecasts.start);
+    check(parser, "forecasts.length", -1, weather.forecasts.length, wire.forecasts.length);
+    for (int i = 0; i < weather.forecasts.length && i < wire.forecasts.length; i++) {
+        const WeatherForecast &f = weather.forecasts[i], &w = wire.forecasts[i];
+        check(parser, "forecasts.weekDay", i, f.weekDay, w.weekDay);
+        check(parser, "forecasts.icon", i, f.icon, w.icon);
+        check(parser, "forecasts.temp_max", i, f.temp_max, w.temp_max);
+        check(parser, "forecasts.temp_min", i, f.temp_min, w.temp_min);
+        check(parser, "forecasts.precipitation", i, f.precipitation_sum, w.precipitation_sum);
+    }
+
+    checkSeries(parser, "icons", weather.icons, wire.icons);
+    checkSeries(parser, "temperature_1h", weather.temperature_1h, wire.temperature_1h);
+    checkSeries(parser, "precipitation_1h", weather.precipitation_1h, wire.precipitation_1h);
+    checkSeries(parser, "precipitation_10min", weather.precipitation_10min, wire.precipitation_10min);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        fprintf(stderr, "usage: %s <time> <TZ> <response.json> < weather.bin\n", argv[0]);
+        return 2;
+    }
+
+    time_t now = atoll(argv[1]);
+    if (!Civil::setZone(argv[2])) {
+        fprintf(stderr, "invalid TZ %s\n", argv[2]);
+        return 2;
+    }
+
+    FILE *f = fopen(argv[3], "rb");
+    if (f == NULL) {
+        fprintf(stderr, "can not open %s\n", argv[3]);
+        return 2;
+    }
+    std::vector<char> json;
+    int c;
+    while ((c = fgetc(f)) != EOF) json.push_back(c);
+    json.push_back(0);
+    fclose(f);
+
+    static uint8_t data[WIRE_MAX_SIZE];
+    size_t length = fread(data, 1, sizeof(data), stdin);
+
+    Weather wire;
+    memset(&wire, 0, sizeof(wire));
+    if (!WeatherAPI::decodeWeather(data, length, &wire, horizon, now)) {
+        fprintf(stderr, "invalid weather (%zu bytes)\n", length);
+        return 2;
+    }
+
+#if WEATHER_JSON
+    {
+        DynamicJsonDocument doc(JSON_CAPACITY);
+        StaticJsonDocument<JSON_FILTER_CAPACITY> filter;
+        WeatherAPI::buildFilter(filter);
+        DeserializationError error = deserializeJson(doc, json.data(), DeserializationOption::Filter(filter));
+        if (error) {
+            fprintf(stderr, "deserializeJson() failed: %s\n", error.c_str());
+            return 2;
+        }
+
+        Weather weather;
+        memset(&weather, 0, sizeof(weather));
+        WeatherAPI::parseWeather(doc, &weather, horizon, now);
+        compare("parseWeather", weather, wire);
+    }
+#endif
+
+    {
+        Weather weather;
+        memset(&weather, 0, sizeof(weather));
+        WeatherParser parser(&weather, horizon, now);
+        if (!parser.parse(json.data())) {
+            fprintf(stderr, "WeatherParser failed: %s\n", parser.errorString());
+            return 2;
+        }
+        compare("WeatherParser", weather, wire);
+    }
+
+    if (failures == 0) {
+        printf("wire: %zu bytes, %d forecasts, same weather as the JSON response\n", length, wire.forecasts.length);
+    }
+    return failures == 0 ? 0 : 1;
+}
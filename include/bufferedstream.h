@@ -0,0 +1,59 @@
+#ifndef BufferedStream_h
+#define BufferedStream_h
+
+#include <Arduino.h>
+#include <Client.h>
+
+#define STREAM_BUFFER_SIZE 1024 // read from the client per call, a TLS record holds up to 16 KB
+
+/*
+ * Client that hands out blocks with read(buf, size). readBytes copies what read() returns
+ * at once instead of byte by byte like Stream::readBytes, waits up to the timeout for
+ * more and stops early once the stream is no longer connected().
+ */
+class BlockClient : public Client {
+    public:
+        using Stream::readBytes;
+        size_t readBytes(char *buf, size_t size);
+};
+
+/*
+ * Read-ahead buffer in front of a client. Every read() of WiFiClientSecure costs an
+ * available() check and an mbedtls_ssl_read for a single byte, here the client is
+ * read in blocks and bytes are handed out of the buffer. Writes go straight through.
+ */
+class BufferedStream : public BlockClient {
+    Client &client;
+    uint8_t buffer[STREAM_BUFFER_SIZE];
+    size_t position = 0;
+    size_t length = 0;
+
+    bool fill();
+
+    public:
+        // bytes handed out, calls of the reader, reads of the client
+        unsigned long bytes = 0;
+        unsigned long calls = 0;
+        unsigned long fills = 0;
+
+        BufferedStream(Client &client) : client(client) {};
+
+        // drop what is buffered and reset the statistics (before a new request)
+        void reset();
+
+        int available();
+        int read();
+        int read(uint8_t *buf, size_t size);
+        int peek();
+
+        int connect(IPAddress ip, uint16_t port) { reset(); return client.connect(ip, port); }
+        int connect(const char *host, uint16_t port) { reset(); return client.connect(host, port); }
+        size_t write(uint8_t c) { return client.write(c); }
+        size_t write(const uint8_t *buf, size_t size) { return client.write(buf, size); }
+        void flush() { client.flush(); }
+        void stop() { client.stop(); }
+        uint8_t connected() { return length > position || client.connected(); }
+        operator bool() { return length > position || (bool)client; }
+};
+
+#endif /* BufferedStream_h */
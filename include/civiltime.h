@@ -0,0 +1,45 @@
+#ifndef CivilTime_h
+#define CivilTime_h
+
+#include <stdint.h>
+#include <time.h>
+
+#define SECONDS_PER_DAY 86400
+
+/*
+ * Calendar math on days since 1970-01-01 and the local time zone from a POSIX TZ
+ * string (e.g. "CET-1CEST,M3.5.0,M10.5.0/3"), without going through the TZ
+ * handling of localtime / mktime. The zone is set once per wake with setZone.
+ */
+namespace Civil {
+    struct DateTime {
+        int32_t days; // since 1970-01-01
+        int16_t year;
+        uint8_t month; // 1 - 12
+        uint8_t day; // 1 - 31
+        uint8_t hour;
+        uint8_t minute;
+        uint8_t second;
+        uint8_t weekday; // 0 = sunday
+    };
+
+    int32_t daysFromCivil(int year, int month, int day);
+    void civilFromDays(int32_t days, int &year, int &month, int &day);
+    int weekday(int32_t days);
+
+    // "YYYY-MM-DD", false if it is not a valid date
+    bool parseDate(const char *str, int32_t *days);
+
+    // false if tz can not be parsed, UTC is used then
+    bool setZone(const char *tz);
+
+    // seconds east of UTC at utc, DST included
+    int32_t utcOffset(time_t utc);
+    DateTime local(time_t utc);
+
+    // round utc down to a multiple of seconds in local time (an hour, 3 hours, a day),
+    // converted back with the UTC offset in effect at the result
+    time_t floorLocal(time_t utc, int32_t seconds);
+}
+
+#endif /* CivilTime_h */
@@ -1,10 +1,14 @@
 #ifndef Display_h
 #define Display_h
 
+#include <Client.h>
+
 #include "epd4in2.h"
 #include "epdpaint.h"
 
 #include "weather.h"
+#include "refresh.h"
+#include "frame.h"
 
 typedef enum updateError {
     ENone,
@@ -13,20 +17,57 @@ typedef enum updateError {
     EWeather
 } UpdateError;
 
+// Everything needed to render a frame again (e.g. to know what is shown on the panel)
+struct RenderState {
+    bool valid;
+    int current_hour;
+    int offset_hour;
+    UpdateError error;
+    Weather weather;
+};
+
+// Panel the station is built for, see epdpanel.h (build with -DTRICOLOR for the black / white / red panel,
+// -DGRAYSCALE for the 4 level gray waveform)
+#ifdef TRICOLOR
+typedef Panel4in2Red DisplayPanel;
+#elif defined(GRAYSCALE)
+typedef Panel4in2Gray DisplayPanel;
+#else
+typedef Panel4in2 DisplayPanel;
+#endif
+
 class Display {
     bool initialized;
-    Epd epd;
+    BasicEpd<DisplayPanel> epd;
 
-    const int width = 400; //width should be the multiple of 8
-    const int height = 300;
+    static const int width = DisplayPanel::width;
+    static const int height = DisplayPanel::height;
+    static_assert(width >= 400 && height >= 300, "layout is made for 400x300");
 
+    // one band of the frame, the whole frame for single band panels
     unsigned char *buffer;
-    Paint *paint;
-    
+    BasicPaint<DisplayPanel> *paint;
+
+    // red plane of the same band (tri-color panels only), used for warnings
+    unsigned char *buffer_red = nullptr;
+    BasicPaint<DisplayPanel> *paint_red = nullptr;
+
     unsigned char *icon_buffer;
-    Paint *paint_icon;
+    BasicPaint<DisplayPanel> *paint_icon;
+
+    static void sendBand(void *display, const uint8_t *band, int index);
+    static int slotOffset(int offset_hour);
+    static int dayOffset(const Weather &weather, time_t time);
+    void drawChanges(const RenderState &state, const RenderState &shown, RefreshPolicy &policy);
 
     public:
+        // how far ahead the layout shows the weather, see Horizon
+        static const Horizon horizon;
+
+        // weather still holds everything the layout shows at current_time as if it was fresh
+        // (an answer 304 keeps older data)
+        static bool covers(const Weather &weather, time_t current_time);
+
         ~Display();
         bool initialize(bool clear_buffer);
         void calculateResolution(float &y_lower, float &y_upper, float &step);
@@ -40,15 +81,21 @@ class Display {
         void render24hIcons(const Weather &weather, int num_steps, int start_hour, int offset_hour);
         void renderTodayOverview(const WeatherForecast &forecast, time_t start);
         void renderCurrentWeather(const Weather &weather, int current_hour, int offset_hour);
-        void renderWeather(const Weather weather, int current_hour, int offset_hour);
+        void renderWeather(const Weather &weather, int current_hour, int offset_hour);
         void renderText(int x, int y, const char *str, const unsigned char *font, const int *info);
         void renderError(UpdateError error);
+        void renderStale(int x0, int y0, int x1, int y1);
+        void render(const RenderState &state);
 
         int getTextWidth(const char *str, const unsigned char *font, const int *info);
         int getLetterForFont(int letter, const unsigned char *font, const int *info);
 
         void print();
         void draw();
+        void draw(RefreshPolicy &policy);
+        void draw(const RenderState &state, const RenderState &shown, RefreshPolicy &policy);
+        void drawBands(const RenderState &state, RefreshPolicy &policy);
+        bool drawFrame(Client &client);
 
 };
 
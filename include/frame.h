@@ -0,0 +1,55 @@
+#ifndef Frame_h
+#define Frame_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef USE_THIN_CLIENT
+#define USE_THIN_CLIENT 0 // fetch the rendered frame from resources/weather_proxy.py --renderer
+#endif
+
+/*
+ * Pre-rendered frame for thin clients:
+ *   "WXF" version:u8 width:u16 height:u16 (little endian)
+ * followed by the 1 bit plane (rows msb first, set = white) in PackBits: a control
+ * byte n < 128 copies the next n + 1 bytes, n > 128 repeats the next byte 257 - n times.
+ */
+#define FRAME_VERSION 1
+#define FRAME_HEADER_SIZE 8
+
+// called with every band_size bytes of the plane, index counts the bands
+typedef void (*FrameBandCallback)(void *context, const uint8_t *band, int index);
+
+class FrameDecoder {
+    uint8_t *band;
+    int band_size;
+    int filled = 0;
+    int index = 0;
+    FrameBandCallback callback;
+    void *context;
+
+    uint8_t header[FRAME_HEADER_SIZE];
+    int header_length = 0;
+    int literal = 0; // bytes left to copy
+    int repeat = 0; // > 0: waiting for the byte to repeat
+    long size = 0; // plane bytes left
+
+    void write(uint8_t value, int count);
+
+    public:
+        int width = 0;
+        int height = 0;
+        bool error = false;
+
+        FrameDecoder(uint8_t *band, int band_size, FrameBandCallback callback, void *context) :
+            band(band), band_size(band_size), callback(callback), context(context) {};
+
+        // false once the frame is broken (wrong header, too much data)
+        bool feed(uint8_t c);
+        bool done();
+};
+
+// PackBits of plane with the header, 0 if out is too small (host side)
+size_t encodeFrame(const uint8_t *plane, int width, int height, uint8_t *out, size_t capacity);
+
+#endif /* Frame_h */
@@ -0,0 +1,101 @@
+#ifndef Http_h
+#define Http_h
+
+#include <Arduino.h>
+#include <Client.h>
+
+#include "bufferedstream.h"
+
+#define HTTP_REQUEST_SIZE 512 // request line and headers, written at once
+#define HTTP_LINE_SIZE 128 // status and header lines, longer ones are cut
+#define HTTP_HEAD_TIMEOUT 10000 // ms for the status line and headers
+#define HTTP_BODY_TIMEOUT 5000 // ms without body data
+#define HTTP_VALIDATOR_SIZE 64 // ETag and Last-Modified, longer ones are not kept
+
+// what identifies a response version, sent back as If-None-Match / If-Modified-Since
+struct HttpValidators {
+    char etag[HTTP_VALIDATOR_SIZE];
+    char last_modified[HTTP_VALIDATOR_SIZE];
+};
+
+// Request assembled in a fixed buffer, sent with a single write (one TLS record)
+class HttpRequest {
+    char buffer[HTTP_REQUEST_SIZE];
+    size_t length = 0;
+    bool overflow = false;
+
+    void append(const char *str, size_t n);
+
+    public:
+        // request line and headers separated by \n (headers of wifi_login.h), Host is added if missing
+        void begin(const char *lines, const char *host);
+        void header(const char *name, const char *value);
+        // ask for the body only if it changed since the response of validators (304 otherwise)
+        void conditional(const HttpValidators &validators);
+
+        // false if the request did not fit
+        bool send(Client &client);
+};
+
+typedef enum httpFraming {
+    HUntilClose, // HTTP/1.0 style, the body ends with the connection
+    HLength,     // Content-Length
+    HChunked     // Transfer-Encoding: chunked
+} HttpFraming;
+
+typedef enum httpEncoding {
+    HIdentity,
+    HGzip,
+    HDeflate,
+    HUnsupported
+} HttpEncoding;
+
+struct HttpResponse {
+    int status;
+    HttpFraming framing;
+    long content_length;
+    HttpEncoding encoding; // Content-Encoding
+    HttpValidators validators;
+};
+
+// status line and headers, read in a fixed line buffer. false on timeout or a malformed status
+bool readResponseHead(Client &client, HttpResponse &response, unsigned long timeout);
+
+/*
+ * Body of a response as a client of its own: framing (chunk sizes, trailer) is removed and
+ * the body ends where the response does, even if the connection is kept open.
+ */
+class HttpBody : public BlockClient {
+    Client *client = nullptr;
+    HttpFraming framing = HUntilClose;
+    uint8_t state = 0;
+    long remaining = 0; // bytes left of the body or the current chunk
+    uint8_t digits = 0; // of the chunk size
+
+    bool advance();
+    void consumed(int n);
+
+    public:
+        bool error = false; // broken chunk framing
+
+        void begin(Client &client, const HttpResponse &response);
+        // the whole body was read
+        bool done();
+
+        int available();
+        int read();
+        int read(uint8_t *buf, size_t size);
+        int peek();
+        uint8_t connected();
+        operator bool() { return connected(); }
+
+        // the body is read only
+        int connect(IPAddress, uint16_t) { return 0; }
+        int connect(const char *, uint16_t) { return 0; }
+        size_t write(uint8_t) { return 0; }
+        size_t write(const uint8_t *, size_t) { return 0; }
+        void flush() {};
+        void stop() {};
+};
+
+#endif /* Http_h */
@@ -0,0 +1,83 @@
+#ifndef Inflate_h
+#define Inflate_h
+
+#include <Arduino.h>
+#include <Client.h>
+#include <rom/miniz.h>
+
+#include "bufferedstream.h"
+
+#ifndef USE_COMPRESSION
+#define USE_COMPRESSION 1 // ask for gzip / deflate responses, inflated while they are read
+#endif
+
+// power of 2, allocated only while a compressed response is read (plus ~11 KB for the decompressor)
+#ifndef INFLATE_WINDOW_SIZE
+#define INFLATE_WINDOW_SIZE 16384
+#endif
+#define INFLATE_INPUT_SIZE 512
+
+typedef enum inflateFormat {
+    IGzip, // Content-Encoding: gzip
+    IZlib  // Content-Encoding: deflate
+} InflateFormat;
+
+/*
+ * Decompressed view of a compressed body, inflated by the tinfl of the ESP32 ROM. The output
+ * goes round a window of INFLATE_WINDOW_SIZE. Deflate may refer back 32 KB, with a smaller window
+ * the stream is only decoded as far as it is safe: up to the window size, unless the zlib header
+ * promises a window that fits.
+ */
+class InflateStream : public BlockClient {
+    Client *client = nullptr;
+    tinfl_decompressor *decompressor = nullptr;
+    uint8_t *window = nullptr;
+    uint8_t input[INFLATE_INPUT_SIZE];
+    size_t input_position = 0;
+    size_t input_length = 0;
+
+    size_t window_position = 0; // where the next output goes
+    size_t output_position = 0; // next byte to hand out
+    size_t pending = 0; // bytes to hand out
+    unsigned long total = 0; // bytes inflated
+    bool window_fits = false; // every back reference lies in the window
+
+    InflateFormat format;
+    uint8_t header_state = 0;
+    uint8_t header_flags = 0;
+    uint8_t header_count = 0; // bytes of the current field
+    uint16_t extra_length = 0;
+    bool finished = false;
+
+    void nextField();
+    bool header(uint8_t c);
+    bool pump();
+
+    public:
+        bool error = false; // broken stream or window too small
+
+        ~InflateStream() { end(); };
+
+        // false if the buffers could not be allocated
+        bool begin(Client &client, InflateFormat format);
+        void end();
+        bool done() { return finished && pending == 0; };
+        unsigned long inflated() { return total; };
+
+        int available();
+        int read();
+        int read(uint8_t *buf, size_t size);
+        int peek();
+        uint8_t connected();
+        operator bool() { return connected(); }
+
+        // decompressed data is read only
+        int connect(IPAddress, uint16_t) { return 0; }
+        int connect(const char *, uint16_t) { return 0; }
+        size_t write(uint8_t) { return 0; }
+        size_t write(const uint8_t *, size_t) { return 0; }
+        void flush() {};
+        void stop() {};
+};
+
+#endif /* Inflate_h */
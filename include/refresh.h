@@ -0,0 +1,26 @@
+#ifndef Refresh_h
+#define Refresh_h
+
+#include <stdint.h>
+
+#define FULL_REFRESH_INTERVAL 12 // force a full refresh after this many partial ones (ghosting)
+#define MAX_PARTIAL_PERCENT 30 // changed area above which a full refresh looks better anyway
+
+typedef enum refreshMode {
+    RNone,
+    RPartial,
+    RFull
+} RefreshMode;
+
+class RefreshPolicy {
+    // number of partial refreshes since the last full one, kept in RTC RAM by the caller
+    uint8_t &partial_count;
+
+    public:
+        RefreshPolicy(uint8_t &partial_count) : partial_count(partial_count) {};
+
+        RefreshMode select(bool has_previous, unsigned int changed_pixels, unsigned int total_pixels);
+        void commit(RefreshMode mode);
+};
+
+#endif /* Refresh_h */
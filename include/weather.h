@@ -2,46 +2,157 @@
 #define WeatherForecast_h
 
 #include <stdint.h>
+#include <math.h>
+#include <limits>
 #include <Arduino.h>
 
+#ifndef WEATHER_JSON
+#define WEATHER_JSON 1 // JSON responses through ArduinoJson, host builds only decode the wire format
+#endif
+
+#if WEATHER_JSON
 #define ARDUINOJSON_USE_LONG_LONG 1
 #include <ArduinoJson.h>
+#endif
+
+// filtered response: modelled by resources/json_capacity.py from sample_response.json only (8092 bytes,
+// +25%), not measured on the device. main.cpp logs the real usage ("JSON memory usage")
+#define JSON_CAPACITY 10240
+#define JSON_FILTER_CAPACITY 512
+#ifndef USE_STREAM_PARSER
+#define USE_STREAM_PARSER 1 // parse the response while it arrives (weatherparser.h) instead of into a JsonDocument
+#endif
+#ifndef USE_WIRE_FORMAT
+#define USE_WIRE_FORMAT 0 // the server is resources/weather_proxy.py, it answers in the binary format below
+#endif
 
-#define JSON_CAPACITY 32768
+/*
+ * Binary wire format, little endian, values in the fixed point of Weather:
+ *   "WXB" version:u8
+ *   current   time:u32 icon:u8 temperature:i16
+ *   forecasts count:u8 {day:u16 (since 1970-01-01) icon:u8 max:i16 min:i16 precipitation:u16}
+ *   series    start:u32 count:u8 {value} for weatherIcon3h (u8), temperatureMean1h (i16),
+ *             precipitation1h (u8), precipitation10m (u8)
+ * Series are complete from their start, the device slices them like the JSON response.
+ */
+#define WIRE_VERSION 1
+#define WIRE_MAX_SIZE 512 // largest response accepted
 
 #define HOUR_START 6
-#define NUM_FORECASTS 6
-#define NUM_3H 11
-#define NUM_1H 33
-#define NUM_10MIN 42
+
+// Memory budget of Weather (RTC RAM): longest horizon each series can hold
+#define MAX_3H 16 // 48 hours
+#define MAX_1H 48 // 48 hours
+#define MAX_10MIN 96 // 16 hours, 7 shown and 9 more while an answer 304 keeps the data
+#define MAX_FORECASTS 8 // today and 7 days
+
+// series resolution in seconds
+#define STEP_3H 10800
+#define STEP_1H 3600
+#define STEP_10MIN 600
+#define STEP_DAY 86400
+
+// Weather is kept in RTC RAM, values are stored in fixed point (use the accessors)
+#define SCALE_TEMPERATURE 10.f // 0.1 deg C
+#define SCALE_PRECIPITATION 10.f // 0.1 mm
+
+// round to fixed point, saturating at the limits of T
+template <typename T>
+inline T quantize(float value, float scale) {
+    float v = roundf(value * scale);
+    if (v <= std::numeric_limits<T>::min()) return std::numeric_limits<T>::min();
+    if (v >= std::numeric_limits<T>::max()) return std::numeric_limits<T>::max();
+    return static_cast<T>(v);
+}
+
+// Fixed capacity time series, element i is at start + i * step
+template <typename T, int CAPACITY>
+struct Series {
+    uint32_t start;
+    uint32_t step;
+    uint8_t length;
+    T values[CAPACITY];
+
+    static const int capacity = CAPACITY;
+
+    const T &operator[](int i) const { return values[i]; }
+    bool has(int i) const { return i >= 0 && i < length; }
+
+    // store element i, the series grows up to it. false if it does not fit
+    bool set(int i, const T &value) {
+        if (i < 0 || i >= CAPACITY) return false;
+        values[i] = value;
+        if (i >= length) length = i + 1;
+        return true;
+    }
+};
+
+// How far ahead a layout shows the weather, series are cut to their capacity
+struct Horizon {
+    uint8_t hours; // 3 hour icons, 1 hour temperature and precipitation
+    uint8_t hours_10min; // 10 minute precipitation
+    uint8_t days; // daily forecasts, today included
+
+    int steps3h() const { return (hours + 2) / 3; }
+    int steps1h() const { return hours; }
+    int steps10min() const { return hours_10min * 6; }
+};
 
 struct WeatherForecast {
     uint8_t weekDay;
     uint8_t icon;
-    float tempMax;
-    float tempMin;
-    float precipitation;
+    int16_t temp_max;
+    int16_t temp_min;
+    uint16_t precipitation_sum;
+
+    float tempMax() const { return temp_max / SCALE_TEMPERATURE; }
+    float tempMin() const { return temp_min / SCALE_TEMPERATURE; }
+    float precipitation() const { return precipitation_sum / SCALE_PRECIPITATION; }
+
+    void setTempMax(float t) { temp_max = quantize<int16_t>(t, SCALE_TEMPERATURE); }
+    void setTempMin(float t) { temp_min = quantize<int16_t>(t, SCALE_TEMPERATURE); }
+    void setPrecipitation(float p) { precipitation_sum = quantize<uint16_t>(p, SCALE_PRECIPITATION); }
 };
 
 struct CurrentWeather {
     uint32_t time;
     uint8_t icon;
-    float temperature;
+    int16_t temperature_value;
+
+    float temperature() const { return temperature_value / SCALE_TEMPERATURE; }
+    void setTemperature(float t) { temperature_value = quantize<int16_t>(t, SCALE_TEMPERATURE); }
 };
 
 struct Weather {
-    uint32_t start;
-    uint32_t start_low;
-    uint8_t icons[NUM_3H];
-    float precipitation1h[NUM_1H];
-    float precipitation10min[NUM_10MIN];
-    float temperatures[NUM_1H];
+    uint32_t start; // first hour shown, rounded down to 3 hours
+    Series<uint8_t, MAX_3H> icons;
+    Series<uint8_t, MAX_1H> precipitation_1h; // starts at startLowResolution, saturates at 25.5 mm
+    Series<uint8_t, MAX_10MIN> precipitation_10min;
+    Series<int16_t, MAX_1H> temperature_1h;
     CurrentWeather current;
-    WeatherForecast forecasts[NUM_FORECASTS];
+    Series<WeatherForecast, MAX_FORECASTS> forecasts; // today first
+
+    float precipitation1h(int i) const { return precipitation_1h[i] / SCALE_PRECIPITATION; }
+    float precipitation10min(int i) const { return precipitation_10min[i] / SCALE_PRECIPITATION; }
+    float temperature(int i) const { return temperature_1h[i] / SCALE_TEMPERATURE; }
+
+    // move all series to begin at time (used to show an old sample as if it was current)
+    void rebase(uint32_t time) {
+        start = time;
+        icons.start = time;
+        precipitation_1h.start = time;
+        precipitation_10min.start = time;
+        temperature_1h.start = time;
+    }
 };
 
 namespace WeatherAPI {
-    bool parseWeather(DynamicJsonDocument &doc, Weather *weather, time_t current_time);
+    int seriesOffset(time_t start, int step, time_t from);
+#if WEATHER_JSON
+    void buildFilter(JsonDocument &filter);
+    bool parseWeather(DynamicJsonDocument &doc, Weather *weather, const Horizon &horizon, time_t current_time);
+#endif
+    bool decodeWeather(const uint8_t *data, size_t length, Weather *weather, const Horizon &horizon, time_t current_time);
 }
 
 #endif /* WeatherForecast_h */
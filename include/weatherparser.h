@@ -0,0 +1,108 @@
+#ifndef WeatherParser_h
+#define WeatherParser_h
+
+#include <stdint.h>
+#include <time.h>
+#include <Arduino.h>
+#include <Client.h>
+
+#include "weather.h"
+#include "civiltime.h"
+
+#define PARSER_MAX_DEPTH 4 // root > graph > series, root > forecast > day
+#define PARSER_MAX_TOKEN 24 // longest key or value we have to look at
+#define PARSER_TIMEOUT 5000 // ms without data before giving up
+
+typedef enum parserError {
+    PNone,
+    PSyntax,     // not JSON
+    PDepth,      // nested deeper than the schema
+    PToken,      // value of a known field too long
+    PSchema,     // series before its start time, missing fields, no date
+    PIncomplete  // stream ended before the document
+} ParserError;
+
+// Fields of the weather response the parser looks at, everything else is skipped
+typedef enum parserField {
+    FUnknown,
+    FCurrentWeather,
+    FForecast,
+    FGraph,
+    FTime,
+    FIcon,
+    FTemperature,
+    FDayDate,
+    FIconDay,
+    FTemperatureMax,
+    FTemperatureMin,
+    FPrecipitation,
+    FStart,
+    FStartLow,
+    FIcon3h,
+    FTemperatureMean1h,
+    FPrecipitation1h,
+    FPrecipitation10m
+} ParserField;
+
+/*
+ * Event driven parser for the weather response. Bytes are fed as they arrive and
+ * values are written to Weather right away, no document is kept in memory. Series
+ * are cut to the horizon of the layout.
+ * graph.start and graph.startLowResolution have to come before the series.
+ */
+class WeatherParser {
+    Weather *weather;
+    Horizon horizon;
+    time_t rounded_time = 0; // first hour of the series, rounded down to 3 hours
+    time_t today_start = 0;
+    int32_t today = 0; // local date, days since 1970-01-01
+
+    // lexer
+    uint8_t state;
+    bool is_key;
+    char token[PARSER_MAX_TOKEN];
+    uint8_t token_length;
+    bool token_overflow;
+    uint8_t unicode_digits;
+
+    // open containers, key and member / element index of each
+    uint8_t depth = 0;
+    char containers[PARSER_MAX_DEPTH];
+    uint8_t fields[PARSER_MAX_DEPTH];
+    uint16_t indices[PARSER_MAX_DEPTH];
+
+    // forecast entry, kept until its date is known
+    WeatherForecast forecast;
+    bool forecast_today = false;
+    bool forecast_started = false;
+
+    uint32_t start = 0, start_low = 0;
+    bool has_current = false;
+
+    void setTime(time_t current_time);
+    bool fail(ParserError error);
+    bool open(char container);
+    bool close(char container);
+    bool endToken();
+    bool key();
+    bool value(bool is_string);
+    void seriesValue(ParserField field, int index, float value);
+    template <typename T, int CAPACITY>
+    void setSeries(Series<T, CAPACITY> &series, time_t series_start, int step);
+
+    public:
+        ParserError error = PNone;
+
+        // current_time 0 takes the time of the response (built-in sample)
+        WeatherParser(Weather *weather, const Horizon &horizon, time_t current_time);
+
+        bool feed(char c);
+        bool done();
+        bool finish();
+        bool parse(Client &client);
+        bool parse(const char *json);
+
+        const char *errorString();
+};
+
+#endif /* WeatherParser_h */
@@ -3,19 +3,63 @@
 
 #include <WiFiClientSecure.h>
 
+#include "bufferedstream.h"
+#include "http.h"
+#include "inflate.h"
+
+// largest TLS record the server is asked to send (512 - 4096), 0 to ask for nothing (16 KB records)
+#ifndef TLS_MAX_FRAGMENT
+#define TLS_MAX_FRAGMENT 4096
+#endif
+
+#define WIFI_FAST_TIMEOUT 2000 // ms to associate with the cached access point before scanning
+
+// what the last connect found, kept in RTC memory: access point (no scan) and DHCP lease (no DHCP)
+struct WiFiCache {
+    bool valid;
+    uint8_t bssid[6];
+    int32_t channel;
+    uint32_t ip, gateway, subnet, dns1, dns2;
+    uint32_t obtained, expires; // time() the lease came from DHCP and when it ends (option 51)
+};
+
 class WebRequest {
   bool connected = false;
+  uint32_t heap_before = 0; // free heap before the TLS connection
+
+  bool waitConnected(unsigned long associate, unsigned long address);
+  bool connectCached();
+  void saveCache(bool dhcp);
   
   public:
     WiFiClientSecure client;
+    BufferedStream stream = BufferedStream(client); // the connection, read through this, not client
+    HttpResponse response = {0};
+    HttpBody body; // the body as sent
+    InflateStream inflate; // and decompressed, if it was
+    const HttpValidators *conditional = nullptr; // of the data at hand, the server may answer 304
+    WiFiCache *wifi_cache = nullptr; // set to connect fast and keep it up to date
     
-    WebRequest(){};
+    WebRequest();
     ~WebRequest();
 
     bool connect();
     void disconnect();
 
+    // server authentication (SERVER_CA_DER and SERVER_PIN, or SERVER_PSK of wifi_login.h are set by default)
+    bool setTrustAnchor(const uint8_t *der, size_t length) { return client.addTrustAnchor(der, length); }
+    bool setServerPin(const char *sha256) { return client.setPublicKeyPin(sha256); }
+    // PSK-TLS instead of certificates (key in hex), e.g. to weather_proxy.py --psk on the LAN
+    void setPreSharedKey(const char *identity, const char *key) { client.setPreSharedKey(identity, key); }
+
+    // true once a 2xx status and the headers are read, the body follows in content()
     bool requestWeather();
+    // consumers read the decoded response body from here
+    Client &content();
+    // requestWeather failed because the data at hand is current
+    bool notModified() { return response.status == 304; }
+    int readBody(uint8_t *buffer, size_t size);
+    void printStatistics();
 };
 
 #endif /* WebRequest_h */
\ No newline at end of file
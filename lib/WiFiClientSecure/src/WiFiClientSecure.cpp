@@ -36,6 +36,11 @@ WiFiClientSecure::WiFiClientSecure()
     ssl_init(sslclient);
     sslclient->socket = -1;
     sslclient->handshake_timeout = 120000;
+    sslclient->mfl_code = MBEDTLS_SSL_MAX_FRAG_LEN_NONE;
+    sslclient->trust_anchors = NULL;
+    sslclient->pin_set = false;
+    sslclient->session = NULL;
+    mbedtls_x509_crt_init(&_trust_anchors);
     _CA_cert = NULL;
     _cert = NULL;
     _private_key = NULL;
@@ -53,6 +58,11 @@ WiFiClientSecure::WiFiClientSecure(int sock)
     ssl_init(sslclient);
     sslclient->socket = sock;
     sslclient->handshake_timeout = 120000;
+    sslclient->mfl_code = MBEDTLS_SSL_MAX_FRAG_LEN_NONE;
+    sslclient->trust_anchors = NULL;
+    sslclient->pin_set = false;
+    sslclient->session = NULL;
+    mbedtls_x509_crt_init(&_trust_anchors);
 
     if (sock >= 0) {
         _connected = true;
@@ -70,6 +80,7 @@ WiFiClientSecure::~WiFiClientSecure()
 {
     stop();
     delete sslclient;
+    mbedtls_x509_crt_free(&_trust_anchors);
 }
 
 WiFiClientSecure &WiFiClientSecure::operator=(const WiFiClientSecure &other)
@@ -112,7 +123,14 @@ int WiFiClientSecure::connect(IPAddress ip, uint16_t port, const char *_CA_cert,
 
 int WiFiClientSecure::connect(const char *host, uint16_t port, const char *_CA_cert, const char *_cert, const char *_private_key)
 {
+    bool resume = sslclient->session && sslclient->session->valid;
     int ret = start_ssl_client(sslclient, host, port, _CA_cert, _cert, _private_key, NULL, NULL);
+    if (ret < 0 && resume && !sslclient->session->valid) {
+        // the handshake with the saved session failed, try once more without it
+        log_w("Resumption failed, full handshake");
+        stop();
+        ret = start_ssl_client(sslclient, host, port, _CA_cert, _cert, _private_key, NULL, NULL);
+    }
     _lastError = ret;
     if (ret < 0) {
         log_e("start_ssl_client: %d", ret);
@@ -124,12 +142,18 @@ int WiFiClientSecure::connect(const char *host, uint16_t port, const char *_CA_c
 }
 
 int WiFiClientSecure::connect(IPAddress ip, uint16_t port, const char *pskIdent, const char *psKey) {
-    return connect(ip.toString().c_str(), port,_pskIdent, _psKey);
+    return connect(ip.toString().c_str(), port, pskIdent, psKey);
 }
 
 int WiFiClientSecure::connect(const char *host, uint16_t port, const char *pskIdent, const char *psKey) {
     log_v("start_ssl_client with PSK");
-    int ret = start_ssl_client(sslclient, host, port, NULL, NULL, NULL, _pskIdent, _psKey);
+    bool resume = sslclient->session && sslclient->session->valid;
+    int ret = start_ssl_client(sslclient, host, port, NULL, NULL, NULL, pskIdent, psKey);
+    if (ret < 0 && resume && !sslclient->session->valid) {
+        log_w("Resumption failed, full handshake");
+        stop();
+        ret = start_ssl_client(sslclient, host, port, NULL, NULL, NULL, pskIdent, psKey);
+    }
     _lastError = ret;
     if (ret < 0) {
         log_e("start_ssl_client: %d", ret);
@@ -243,6 +267,23 @@ void WiFiClientSecure::setPrivateKey (const char *private_key)
     _private_key = private_key;
 }
 
+bool WiFiClientSecure::addTrustAnchor(const uint8_t *der, size_t length)
+{
+    // parsed here once, PEM certificates of setCACert are parsed on every connect
+    int ret = mbedtls_x509_crt_parse_der(&_trust_anchors, der, length);
+    if (ret != 0) {
+        log_e("Trust anchor not parsed: %d", ret);
+        return false;
+    }
+    sslclient->trust_anchors = &_trust_anchors;
+    return true;
+}
+
+bool WiFiClientSecure::setPublicKeyPin(const char *sha256)
+{
+    return set_ssl_pin(sslclient, sha256);
+}
+
 void WiFiClientSecure::setPreSharedKey(const char *pskIdent, const char *psKey) {
     _pskIdent = pskIdent;
     _psKey = psKey;
@@ -317,3 +358,23 @@ void WiFiClientSecure::setHandshakeTimeout(unsigned long handshake_timeout)
 {
     sslclient->handshake_timeout = handshake_timeout * 1000;
 }
+
+bool WiFiClientSecure::setMaxFragmentLength(uint16_t length)
+{
+    switch (length) {
+        case 0: sslclient->mfl_code = MBEDTLS_SSL_MAX_FRAG_LEN_NONE; break;
+        case 512: sslclient->mfl_code = MBEDTLS_SSL_MAX_FRAG_LEN_512; break;
+        case 1024: sslclient->mfl_code = MBEDTLS_SSL_MAX_FRAG_LEN_1024; break;
+        case 2048: sslclient->mfl_code = MBEDTLS_SSL_MAX_FRAG_LEN_2048; break;
+        case 4096: sslclient->mfl_code = MBEDTLS_SSL_MAX_FRAG_LEN_4096; break;
+        default:
+            log_e("Max fragment length must be 512, 1024, 2048 or 4096");
+            return false;
+    }
+    return true;
+}
+
+void WiFiClientSecure::setSession(sslclient_session *session)
+{
+    sslclient->session = session;
+}
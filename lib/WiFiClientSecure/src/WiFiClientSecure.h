@@ -37,6 +37,7 @@ protected:
     const char *_private_key;
     const char *_pskIdent; // identity for PSK cipher suites
     const char *_psKey; // key in hex for PSK cipher suites
+    mbedtls_x509_crt _trust_anchors; // parsed once, kept for every connect
 
 public:
     WiFiClientSecure *next;
@@ -68,6 +69,10 @@ public:
     bool loadPrivateKey(Stream& stream, size_t size);
     bool verify(const char* fingerprint, const char* domain_name);
     void setHandshakeTimeout(unsigned long handshake_timeout);
+    bool setMaxFragmentLength(uint16_t length); // 512, 1024, 2048 or 4096, 0 for the 16 KB default
+    bool addTrustAnchor(const uint8_t *der, size_t length); // root CA in DER, instead of setCACert
+    bool setPublicKeyPin(const char *sha256); // of the server's SubjectPublicKeyInfo, in hex
+    void setSession(sslclient_session *session); // resume and keep the TLS session in session (e.g. RTC memory)
 
     operator bool()
     {
@@ -14,6 +14,7 @@
 #include <lwip/netdb.h>
 #include <mbedtls/sha256.h>
 #include <mbedtls/oid.h>
+#include <mbedtls/ssl_internal.h>
 #include <algorithm>
 #include <string>
 #include "ssl_client.h"
@@ -22,6 +23,13 @@
 
 const char *pers = "esp32-tls";
 
+// plain PSK key exchange only: no certificates, no (EC)DHE, only symmetric crypto in the handshake
+static const int psk_ciphersuites[] = {
+    MBEDTLS_TLS_PSK_WITH_AES_128_GCM_SHA256,
+    MBEDTLS_TLS_PSK_WITH_AES_128_CBC_SHA256,
+    0
+};
+
 static int handle_error(int err)
 {
     if(err == -30848){
@@ -45,6 +53,170 @@ void ssl_init(sslclient_context *ssl_client)
 }
 
 
+// compare the server key with the pin: sha256 of its SubjectPublicKeyInfo (DER)
+static bool match_pin(sslclient_context *ssl_client, mbedtls_x509_crt *crt)
+{
+    unsigned char spki[600]; // RSA 4096 and smaller
+    int len = mbedtls_pk_write_pubkey_der(&crt->pk, spki, sizeof(spki));
+    if (len <= 0) {
+        return false;
+    }
+
+    // written at the end of the buffer
+    uint8_t hash[32];
+    mbedtls_sha256_context sha256_ctx;
+    mbedtls_sha256_init(&sha256_ctx);
+    mbedtls_sha256_starts(&sha256_ctx, false);
+    mbedtls_sha256_update(&sha256_ctx, spki + sizeof(spki) - len, len);
+    mbedtls_sha256_finish(&sha256_ctx, hash);
+    mbedtls_sha256_free(&sha256_ctx);
+
+    return memcmp(hash, ssl_client->pin, sizeof(hash)) == 0;
+}
+
+// the chain is verified against the trust anchors, the server key must match the pin as well
+static int verify_pin(void *ctx, mbedtls_x509_crt *crt, int depth, uint32_t *flags)
+{
+    if (depth == 0 && !match_pin((sslclient_context *)ctx, crt)) {
+        log_e("Server key does not match the pin");
+        return MBEDTLS_ERR_X509_FATAL_ERROR; // ends the handshake, also in optional mode
+    }
+    return 0;
+}
+
+// no trust anchors: the pinned key is trusted, whatever the chain says
+static int verify_pin_only(void *ctx, mbedtls_x509_crt *crt, int depth, uint32_t *flags)
+{
+    int ret = verify_pin(ctx, crt, depth, flags);
+    if (ret == 0) {
+        *flags = 0;
+    }
+    return ret;
+}
+
+// offer a saved session for host:port, mbedtls falls back to a full handshake if the server rejects it
+static bool offer_session(sslclient_context *ssl_client, const char *host, uint32_t port)
+{
+    sslclient_session *saved = ssl_client->session;
+    if (saved == NULL || !saved->valid || saved->port != port || strncmp(saved->host, host, SSL_SESSION_HOST_MAX) != 0) {
+        return false;
+    }
+
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+#if defined(MBEDTLS_HAVE_TIME)
+    session.start = saved->start;
+#endif
+    session.ciphersuite = saved->ciphersuite;
+    session.compression = saved->compression;
+    session.id_len = saved->id_len;
+    memcpy(session.id, saved->id, sizeof(session.id));
+    memcpy(session.master, saved->master, sizeof(session.master));
+    session.verify_result = saved->verify_result;
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && defined(MBEDTLS_SSL_CLI_C)
+    // an expired ticket is left out, the session id may still be known to the server
+    if (saved->ticket_len > 0 && (saved->ticket_lifetime == 0 || time(NULL) - saved->start < saved->ticket_lifetime)) {
+        session.ticket = saved->ticket; // copied by mbedtls_ssl_set_session
+        session.ticket_len = saved->ticket_len;
+        session.ticket_lifetime = saved->ticket_lifetime;
+    }
+#endif
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+    session.mfl_code = saved->mfl_code;
+#endif
+#if defined(MBEDTLS_SSL_TRUNCATED_HMAC)
+    session.trunc_hmac = saved->trunc_hmac;
+#endif
+#if defined(MBEDTLS_SSL_ENCRYPT_THEN_MAC)
+    session.encrypt_then_mac = saved->encrypt_then_mac;
+#endif
+
+    int ret = mbedtls_ssl_set_session(&ssl_client->ssl_ctx, &session);
+    // not mbedtls_ssl_session_free, the ticket is not on the heap
+    mbedtls_platform_zeroize(&session, sizeof(session));
+    if (ret != 0) {
+        log_w("Saved session not usable: %d", ret);
+        return false;
+    }
+    log_v("Offering saved session");
+    return true;
+}
+
+// keep the negotiated session (read in place, mbedtls_ssl_get_session would copy the peer certificate)
+static void save_session(sslclient_context *ssl_client, const char *host, uint32_t port)
+{
+    sslclient_session *saved = ssl_client->session;
+    const mbedtls_ssl_session *session = ssl_client->ssl_ctx.session;
+    if (saved == NULL || session == NULL || strlen(host) >= SSL_SESSION_HOST_MAX) {
+        return;
+    }
+
+    saved->valid = 0;
+    strncpy(saved->host, host, SSL_SESSION_HOST_MAX);
+    saved->port = port;
+#if defined(MBEDTLS_HAVE_TIME)
+    saved->start = session->start;
+#else
+    saved->start = 0;
+#endif
+    saved->ciphersuite = session->ciphersuite;
+    saved->compression = session->compression;
+    saved->id_len = session->id_len;
+    memcpy(saved->id, session->id, sizeof(saved->id));
+    memcpy(saved->master, session->master, sizeof(saved->master));
+    saved->verify_result = session->verify_result;
+    saved->mfl_code = 0;
+    saved->trunc_hmac = 0;
+    saved->encrypt_then_mac = 0;
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+    saved->mfl_code = session->mfl_code;
+#endif
+#if defined(MBEDTLS_SSL_TRUNCATED_HMAC)
+    saved->trunc_hmac = session->trunc_hmac;
+#endif
+#if defined(MBEDTLS_SSL_ENCRYPT_THEN_MAC)
+    saved->encrypt_then_mac = session->encrypt_then_mac;
+#endif
+    saved->ticket_len = 0;
+    saved->ticket_lifetime = 0;
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && defined(MBEDTLS_SSL_CLI_C)
+    if (session->ticket != NULL && session->ticket_len <= SSL_SESSION_TICKET_MAX) {
+        memcpy(saved->ticket, session->ticket, session->ticket_len);
+        saved->ticket_len = session->ticket_len;
+        saved->ticket_lifetime = session->ticket_lifetime;
+    }
+#endif
+
+    // without id or ticket the server has nothing to resume
+    saved->valid = saved->id_len > 0 || saved->ticket_len > 0;
+}
+
+// the offered session was the reason the handshake failed, do not offer it again
+static int drop_session(sslclient_context *ssl_client, bool offered, int err)
+{
+    if (offered) {
+        ssl_client->session->valid = 0;
+    }
+    return err;
+}
+
+// mbedtls_ssl_handshake, noting whether the server resumed the offered session. Only the
+// handshake state knows (a ticket is offered under a fresh session id), it is freed at the end
+static int handshake(mbedtls_ssl_context *ssl, bool *resumed)
+{
+    int ret = 0;
+    while (ssl->state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+        ret = mbedtls_ssl_handshake_step(ssl);
+        if (ssl->handshake != NULL) {
+            *resumed = ssl->handshake->resume != 0;
+        }
+        if (ret != 0) {
+            break;
+        }
+    }
+    return ret;
+}
+
 int start_ssl_client(sslclient_context *ssl_client, const char *host, uint32_t port, const char *rootCABuff, const char *cli_cert, const char *cli_key, const char *pskIdent, const char *psKey)
 {
     char buf[512];
@@ -103,6 +275,15 @@ int start_ssl_client(sslclient_context *ssl_client, const char *host, uint32_t p
         return handle_error(ret);
     }
 
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+    // records of the server stay below it, needed if mbedtls is built with a smaller MBEDTLS_SSL_IN_CONTENT_LEN
+    if (ssl_client->mfl_code != MBEDTLS_SSL_MAX_FRAG_LEN_NONE) {
+        if ((ret = mbedtls_ssl_conf_max_frag_len(&ssl_client->ssl_conf, ssl_client->mfl_code)) != 0) {
+            return handle_error(ret);
+        }
+    }
+#endif
+
     // MBEDTLS_SSL_VERIFY_REQUIRED if a CA certificate is defined on Arduino IDE and
     // MBEDTLS_SSL_VERIFY_NONE if not.
 
@@ -116,6 +297,10 @@ int start_ssl_client(sslclient_context *ssl_client, const char *host, uint32_t p
         if (ret < 0) {
             return handle_error(ret);
         }
+    } else if (ssl_client->trust_anchors != NULL) {
+        log_v("Using pre-parsed trust anchors");
+        mbedtls_ssl_conf_authmode(&ssl_client->ssl_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+        mbedtls_ssl_conf_ca_chain(&ssl_client->ssl_conf, ssl_client->trust_anchors, NULL);
     } else if (pskIdent != NULL && psKey != NULL) {
         log_v("Setting up PSK");
         // convert PSK from hex to binary
@@ -146,11 +331,21 @@ int start_ssl_client(sslclient_context *ssl_client, const char *host, uint32_t p
             log_e("mbedtls_ssl_conf_psk returned %d", ret);
             return handle_error(ret);
         }
+        mbedtls_ssl_conf_ciphersuites(&ssl_client->ssl_conf, psk_ciphersuites);
+    } else if (ssl_client->pin_set) {
+        // there is no chain to require, the pin decides in verify_pin_only
+        mbedtls_ssl_conf_authmode(&ssl_client->ssl_conf, MBEDTLS_SSL_VERIFY_OPTIONAL);
     } else {
         mbedtls_ssl_conf_authmode(&ssl_client->ssl_conf, MBEDTLS_SSL_VERIFY_NONE);
         log_i("WARNING: Use certificates for a more secure communication!");
     }
 
+    if (ssl_client->pin_set && (pskIdent == NULL || psKey == NULL)) {
+        log_v("Pinning server key");
+        bool chain = rootCABuff != NULL || ssl_client->trust_anchors != NULL;
+        mbedtls_ssl_conf_verify(&ssl_client->ssl_conf, chain ? verify_pin : verify_pin_only, ssl_client);
+    }
+
     if (cli_cert != NULL && cli_key != NULL) {
         mbedtls_x509_crt_init(&ssl_client->client_cert);
         mbedtls_pk_init(&ssl_client->client_key);
@@ -187,17 +382,23 @@ int start_ssl_client(sslclient_context *ssl_client, const char *host, uint32_t p
 
     mbedtls_ssl_set_bio(&ssl_client->ssl_ctx, &ssl_client->socket, mbedtls_net_send, mbedtls_net_recv, NULL );
 
+    bool offered = offer_session(ssl_client, host, port);
+    bool resumed = false;
+
     log_v("Performing the SSL/TLS handshake...");
     unsigned long handshake_start_time=millis();
-    while ((ret = mbedtls_ssl_handshake(&ssl_client->ssl_ctx)) != 0) {
+    while ((ret = handshake(&ssl_client->ssl_ctx, &resumed)) != 0) {
         if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
-            return handle_error(ret);
+            return drop_session(ssl_client, offered, handle_error(ret));
         }
         if((millis()-handshake_start_time)>ssl_client->handshake_timeout)
-			return -1;
+			return drop_session(ssl_client, offered, -1);
 	    vTaskDelay(10 / portTICK_PERIOD_MS);
     }
 
+    log_d("Handshake took %lu ms, %s", millis() - handshake_start_time,
+          offered && resumed ? "session resumed" : "full handshake");
+
 
     if (cli_cert != NULL && cli_key != NULL) {
         log_d("Protocol is %s Ciphersuite is %s", mbedtls_ssl_get_version(&ssl_client->ssl_ctx), mbedtls_ssl_get_ciphersuite(&ssl_client->ssl_ctx));
@@ -219,6 +420,24 @@ int start_ssl_client(sslclient_context *ssl_client, const char *host, uint32_t p
     } else {
         log_v("Certificate verified.");
     }
+
+    save_session(ssl_client, host, port);
+
+    // the record buffers are fixed when mbedtls is built, a server that ignores the max fragment length may send 16 KB
+#if defined(MBEDTLS_SSL_IN_CONTENT_LEN)
+    size_t in_len = MBEDTLS_SSL_IN_CONTENT_LEN, out_len = MBEDTLS_SSL_OUT_CONTENT_LEN;
+#else
+    size_t in_len = MBEDTLS_SSL_MAX_CONTENT_LEN, out_len = MBEDTLS_SSL_MAX_CONTENT_LEN;
+#endif
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+    size_t fragment = mbedtls_ssl_get_max_frag_len(&ssl_client->ssl_ctx);
+#else
+    size_t fragment = MBEDTLS_SSL_MAX_CONTENT_LEN;
+#endif
+    log_d("Max fragment %u, record buffers in %u out %u", fragment, in_len, out_len);
+    if (fragment > in_len) {
+        log_w("Records of up to %u bytes do not fit the input buffer of %u", fragment, in_len);
+    }
     
     if (rootCABuff != NULL) {
         mbedtls_x509_crt_free(&ssl_client->ca_cert);
@@ -438,3 +657,29 @@ bool verify_ssl_dn(sslclient_context *ssl_client, const char* domain_name)
 
     return false;
 }
+
+// Pin the server key: sha256 of its SubjectPublicKeyInfo in hex, NULL to stop pinning
+bool set_ssl_pin(sslclient_context *ssl_client, const char* pin)
+{
+    ssl_client->pin_set = false;
+    if (pin == NULL) {
+        return true;
+    }
+
+    int len = strlen(pin);
+    int pos = 0;
+    for (size_t i = 0; i < sizeof(ssl_client->pin); ++i) {
+        while (pos < len && ((pin[pos] == ' ') || (pin[pos] == ':'))) {
+            ++pos;
+        }
+        uint8_t high, low;
+        if (pos > len - 2 || !parseHexNibble(pin[pos], &high) || !parseHexNibble(pin[pos+1], &low)) {
+            log_e("pin is not a sha256 in hex");
+            return false;
+        }
+        pos += 2;
+        ssl_client->pin[i] = low | (high << 4);
+    }
+    ssl_client->pin_set = true;
+    return true;
+}
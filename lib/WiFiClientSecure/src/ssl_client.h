@@ -11,6 +11,33 @@
 #include "mbedtls/entropy.h"
 #include "mbedtls/ctr_drbg.h"
 #include "mbedtls/error.h"
+#include "mbedtls/platform_util.h"
+#include "mbedtls/pk.h"
+
+#define SSL_SESSION_HOST_MAX 64
+#define SSL_SESSION_TICKET_MAX 256
+
+// Negotiated session in flat form (no pointers), can be kept in RTC memory to resume after deep sleep
+typedef struct sslclient_session {
+    uint8_t valid;
+    char host[SSL_SESSION_HOST_MAX];
+    uint16_t port;
+
+    int64_t start;
+    int ciphersuite;
+    int compression;
+    uint8_t id_len;
+    unsigned char id[32];
+    unsigned char master[48];
+    uint32_t verify_result;
+    uint8_t mfl_code;
+    uint8_t trunc_hmac;
+    uint8_t encrypt_then_mac;
+
+    uint16_t ticket_len;
+    uint32_t ticket_lifetime;
+    unsigned char ticket[SSL_SESSION_TICKET_MAX];
+} sslclient_session;
 
 typedef struct sslclient_context {
     int socket;
@@ -25,6 +52,11 @@ typedef struct sslclient_context {
     mbedtls_pk_context client_key;
 
     unsigned long handshake_timeout;
+    unsigned char mfl_code; // MBEDTLS_SSL_MAX_FRAG_LEN_*, asked for in the handshake
+    mbedtls_x509_crt *trust_anchors; // parsed once (DER), used when no PEM root CA is given, NULL for none
+    unsigned char pin[32]; // sha256 of the server's SubjectPublicKeyInfo, checked during the handshake
+    bool pin_set;
+    sslclient_session *session; // offered on connect and updated after the handshake, NULL for none
 } sslclient_context;
 
 
@@ -36,5 +68,6 @@ int send_ssl_data(sslclient_context *ssl_client, const uint8_t *data, uint16_t l
 int get_ssl_receive(sslclient_context *ssl_client, uint8_t *data, int length);
 bool verify_ssl_fingerprint(sslclient_context *ssl_client, const char* fp, const char* domain_name);
 bool verify_ssl_dn(sslclient_context *ssl_client, const char* domain_name);
+bool set_ssl_pin(sslclient_context *ssl_client, const char* pin);
 
 #endif
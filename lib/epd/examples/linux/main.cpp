@@ -0,0 +1,119 @@
+/**
+ *  @filename   :   main.cpp
+ *  @brief      :   Runs the 4.2inch driver against the host recorder and reports
+ *                  bytes sent and simulated panel time for a full and a partial
+ *                  update. The final panel image is written to panel.pbm.
+ *                  Then times rendering a weather station like layout at 1 and
+ *                  2 bits per pixel and shows it with the gray waveform
+ *                  (panel_gray.pgm).
+ *
+ *  Build on the host (no Arduino framework):
+ *      g++ -O2 -I../../src main.cpp ../../src/epd4in2.cpp ../../src/epdpaint.cpp ../../src/epdif_linux.cpp ../../src/epdrecorder.cpp -o epd_linux
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "epd4in2.h"
+#include "epdpaint.h"
+#include "epdrecorder.h"
+
+#define RENDER_RUNS     200
+
+static unsigned char frame[Panel4in2::plane_size];
+static unsigned char previous[Panel4in2::plane_size];
+static unsigned char gray_frame[Panel4in2Gray::plane_size];
+
+static void report(const char* name) {
+    printf("%-8s commands %5lu  data %6lu bytes  delays %5lu ms  refresh %5lu ms  busy polls %lu\n",
+        name, epd_recorder.commands, epd_recorder.data_bytes, epd_recorder.delay_ms,
+        epd_recorder.refresh_ms, epd_recorder.busy_polls);
+    epd_recorder.ResetStats();
+}
+
+/* Lines, bars, icons and an inverted area like the station's layout, returns ms per frame */
+template <class Panel>
+static double render(unsigned char* buffer) {
+    static unsigned char icon[56 * 48 * Panel::bits_per_pixel / 8];
+    const int icon_info[] = {56, 48, 0, 0};
+    const int black = 0, gray = Panel::bits_per_pixel == 2 ? 1 : black;
+
+    BasicPaint<Panel> paint(buffer, Panel::width, Panel::height);
+    BasicPaint<Panel> paint_icon(icon, 56, 48);
+
+    clock_t start = clock();
+    for (int n = 0; n < RENDER_RUNS; n++) {
+        paint.Clear(paint.white);
+        paint_icon.Clear(paint.white);
+        paint_icon.DrawFilledRectangle(6, 20, 50, 44, gray);
+        paint_icon.DrawFilledCircle(24, 20, 14, black);
+
+        paint.DrawHorizontalLine(0, 72, Panel::width, black);
+        paint.DrawHorizontalLine(0, 200, Panel::width, black);
+        for (int i = 0; i < 42; i++) {
+            paint.DrawFilledRectangle(11 + i * 9, 72 - i % 20, 18 + i * 9, 72, gray);
+        }
+        for (int i = 0; i < 12; i++) {
+            paint.DrawImage(icon, icon_info, 15 + (i % 6) * 64, i < 6 ? 2 : 206);
+        }
+        paint.DrawImageDouble(icon, icon_info, 10, 100);
+        paint.InvertRectangle(0, 72, 200, 93, black);
+    }
+    return (clock() - start) * 1000.0 / CLOCKS_PER_SEC / RENDER_RUNS;
+}
+
+int main(int argc, char** argv) {
+    Epd epd;
+    epd_recorder.trace = argc > 1 && strcmp(argv[1], "-v") == 0;
+
+    if (epd.Init() != 0) {
+        return 1;
+    }
+    report("init");
+
+    /* checkerboard of 8x8 blocks, full refresh */
+    for (int y = 0; y < Panel4in2::height; y++) {
+        for (int x = 0; x < Panel4in2::stride; x++) {
+            frame[y * Panel4in2::stride + x] = ((x + y / 8) % 2) ? 0x00 : 0xFF;
+        }
+    }
+    epd.DisplayFrame(frame);
+    report("full");
+
+    /* invert a 64x32 block, partial refresh */
+    memcpy(previous, frame, sizeof(frame));
+    for (int y = 100; y < 132; y++) {
+        for (int x = 8; x < 16; x++) {
+            frame[y * Panel4in2::stride + x] ^= 0xFF;
+        }
+    }
+    epd.DisplayFramePartial(previous, frame, 64, 100, 64, 32);
+    report("partial");
+
+    epd.Sleep();
+    report("sleep");
+
+    if (memcmp(epd_recorder.image, frame, sizeof(frame)) != 0) {
+        printf("panel image differs from frame buffer\n");
+        return 1;
+    }
+
+    if (epd_recorder.WritePbm("panel.pbm") != 0) {
+        return 1;
+    }
+
+    /* the same layout at 1 and 2 bits per pixel */
+    printf("render   1 bpp %.3f ms  2 bpp %.3f ms\n",
+        render<Panel4in2>(frame), render<Panel4in2Gray>(gray_frame));
+
+    BasicEpd<Panel4in2Gray> epd_gray;
+    epd_gray.Init();
+    epd_recorder.ResetStats();
+    epd_gray.DisplayFrame(gray_frame);
+    report("gray");
+    epd_gray.Sleep();
+
+    return epd_recorder.WritePgm("panel_gray.pgm");
+}
+
+/* END OF FILE */
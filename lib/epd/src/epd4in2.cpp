@@ -27,50 +27,119 @@
 #include <stdlib.h>
 #include <epd4in2.h>
 
-Epd::~Epd() {
+/* Command sequences: command, number of data bytes, data...
+ * SEQUENCE_DELAY waits the following byte in ms, SEQUENCE_WAIT_IDLE waits on the
+ * BUSY line, SEQUENCE_END terminates. */
+#define SEQUENCE_DELAY      0xFD
+#define SEQUENCE_WAIT_IDLE  0xFE
+#define SEQUENCE_END        0xFF
+
+static const unsigned char init_sequence[] = {
+    POWER_SETTING, 5,
+        0x03,                       // VDS_EN, VDG_EN
+        0x00,                       // VCOM_HV, VGHL_LV[1], VGHL_LV[0]
+        0x2b,                       // VDH
+        0x2b,                       // VDL
+        0xff,                       // VDHR
+    BOOSTER_SOFT_START, 3,
+        0x17, 0x17, 0x17,           //07 0f 17 1f 27 2F 37 2f
+    POWER_ON, 0,
+    SEQUENCE_WAIT_IDLE,
+    SEQUENCE_END
 };
 
-Epd::Epd() {
+/* Black / white, waveform uploaded by SetLut */
+static const unsigned char panel_bw_sequence[] = {
+    PANEL_SETTING, 2,
+        0xbf,                       // KW-BF   KWR-AF  BWROTP 0f
+        0x0b,
+    PLL_CONTROL, 1,
+        0x3c,                       // 3A 100HZ   29 150Hz 39 200HZ  31 171HZ
+    SEQUENCE_END
+};
+
+/* Black / white / red, waveform from OTP */
+static const unsigned char panel_red_sequence[] = {
+    PANEL_SETTING, 1,
+        0x0f,                       // KWR, LUT from OTP
+    SEQUENCE_END
+};
+
+/* Power off as in the reference driver: VCOM and the gate/source rails are pulled
+ * to 0V and left to discharge before POWER_OFF, which then reports on BUSY */
+static const unsigned char sleep_sequence[] = {
+    VCOM_AND_DATA_INTERVAL_SETTING, 1,
+        0x17,                       //border floating
+    VCM_DC_SETTING, 0,              //VCOM to 0V
+    PANEL_SETTING, 0,
+    SEQUENCE_DELAY, 100,
+    POWER_SETTING, 5,               //VG&VS to 0V fast
+        0x00, 0x00, 0x00, 0x00, 0x00,
+    SEQUENCE_DELAY, 100,
+    POWER_OFF, 0,
+    SEQUENCE_WAIT_IDLE,
+    DEEP_SLEEP, 1,
+        0xA5,                       //check code
+    SEQUENCE_END
+};
+
+template <class Panel>
+BasicEpd<Panel>::~BasicEpd() {
+};
+
+template <class Panel>
+BasicEpd<Panel>::BasicEpd() {
     reset_pin = RST_PIN;
     dc_pin = DC_PIN;
     cs_pin = CS_PIN;
     busy_pin = BUSY_PIN;
-    width = EPD_WIDTH;
-    height = EPD_HEIGHT;
 };
 
-int Epd::Init(void) {
+template <class Panel>
+int BasicEpd<Panel>::Init(void) {
     /* this calls the peripheral hardware interface, see epdif */
     if (IfInit() != 0) {
         return -1;
     }
     /* EPD hardware init start */
     Reset();
-    SendCommand(POWER_SETTING);
-    SendData(0x03);                  // VDS_EN, VDG_EN
-    SendData(0x00);                  // VCOM_HV, VGHL_LV[1], VGHL_LV[0]
-    SendData(0x2b);                  // VDH
-    SendData(0x2b);                  // VDL
-    SendData(0xff);                  // VDHR
-    SendCommand(BOOSTER_SOFT_START);
-    SendData(0x17);
-    SendData(0x17);
-    SendData(0x17);                  //07 0f 17 1f 27 2F 37 2f
-    SendCommand(POWER_ON);
-    WaitUntilIdle();
-    SendCommand(PANEL_SETTING);
-    SendData(0xbf);    // KW-BF   KWR-AF  BWROTP 0f
-    SendData(0x0b);
-    SendCommand(PLL_CONTROL);
-    SendData(0x3c);        // 3A 100HZ   29 150Hz 39 200HZ  31 171HZ
+    RunSequence(init_sequence);
+    RunSequence(Panel::planes == 2 ? panel_red_sequence : panel_bw_sequence);
     /* EPD hardware init end */
     return 0;
 }
 
+/**
+ *  @brief: send a command sequence, see init_sequence
+ */
+template <class Panel>
+void BasicEpd<Panel>::RunSequence(const unsigned char* sequence) {
+    const unsigned char* p = sequence;
+    while (*p != SEQUENCE_END) {
+        if (*p == SEQUENCE_WAIT_IDLE) {
+            WaitUntilIdle();
+            p++;
+            continue;
+        }
+        if (*p == SEQUENCE_DELAY) {
+            DelayMs(p[1]);
+            p += 2;
+            continue;
+        }
+
+        SendCommand(p[0]);
+        for (int i = 0; i < p[1]; i++) {
+            SendData(p[2 + i]);
+        }
+        p += 2 + p[1];
+    }
+}
+
 /**
  *  @brief: basic function for sending commands
  */
-void Epd::SendCommand(unsigned char command) {
+template <class Panel>
+void BasicEpd<Panel>::SendCommand(unsigned char command) {
     DigitalWrite(dc_pin, LOW);
     SpiTransfer(command);
 }
@@ -78,7 +147,8 @@ void Epd::SendCommand(unsigned char command) {
 /**
  *  @brief: basic function for sending data
  */
-void Epd::SendData(unsigned char data) {
+template <class Panel>
+void BasicEpd<Panel>::SendData(unsigned char data) {
     DigitalWrite(dc_pin, HIGH);
     SpiTransfer(data);
 }
@@ -86,9 +156,10 @@ void Epd::SendData(unsigned char data) {
 /**
  *  @brief: Wait until the busy_pin goes HIGH
  */
-void Epd::WaitUntilIdle(void) {
+template <class Panel>
+void BasicEpd<Panel>::WaitUntilIdle(void) {
     while(DigitalRead(busy_pin) == 0) {      //0: busy, 1: idle
-        DelayMs(100);
+        DelayMs(1);
     }      
 }
 
@@ -97,18 +168,109 @@ void Epd::WaitUntilIdle(void) {
  *          often used to awaken the module in deep sleep, 
  *          see Epd::Sleep();
  */
-void Epd::Reset(void) {
+template <class Panel>
+void BasicEpd<Panel>::Reset(void) {
     DigitalWrite(reset_pin, LOW);
-    DelayMs(200);
+    DelayMs(1);                     // datasheet minimum is in the us range
     DigitalWrite(reset_pin, HIGH);
-    DelayMs(200);   
+    DelayMs(1);
+    WaitUntilIdle();                // BUSY stays low until the internal reset is done
 }
 
 /**
  *  @brief: transmit partial data to the SRAM
  */
-void Epd::SetPartialWindow(const unsigned char* buffer_black, int x, int y, int w, int l) {
+template <class Panel>
+void BasicEpd<Panel>::SetPartialWindow(const unsigned char* buffer_black, int x, int y, int w, int l) {
+    if (Panel::bits_per_pixel == 2 && buffer_black != NULL) {
+        // gray: the high bit of each level goes to DTM1, the low bit to DTM2
+        SendPartialPlane(DATA_START_TRANSMISSION_1, buffer_black, 1, x, y, w, l);
+        SendPartialPlane(DATA_START_TRANSMISSION_2, buffer_black, 0, x, y, w, l);
+        return;
+    }
+    SendPartialData(DATA_START_TRANSMISSION_2, buffer_black, 0x00, x, y, w, l);
+}
+
+/**
+ *  @brief: transmit partial old data to the SRAM (DTM1), the image shown on the panel
+ *          for DisplayFramePartial. Without a buffer the window is set to white
+ */
+template <class Panel>
+void BasicEpd<Panel>::SetPartialWindowPrevious(const unsigned char* previous, int x, int y, int w, int l) {
+    SendPartialData(DATA_START_TRANSMISSION_1, previous, 0xFF, x, y, w, l);
+}
+
+/**
+ *  @brief: transmit partial black data to the SRAM (black / white / red panels),
+ *          without a buffer the window is cleared
+ */
+template <class Panel>
+void BasicEpd<Panel>::SetPartialWindowBlack(const unsigned char* buffer_black, int x, int y, int w, int l) {
+    SendPartialData(DATA_START_TRANSMISSION_1, buffer_black, 0xFF, x, y, w, l);
+}
+
+/**
+ *  @brief: transmit partial red data to the SRAM (black / white / red panels),
+ *          bit reset: red, without a buffer the window is cleared
+ */
+template <class Panel>
+void BasicEpd<Panel>::SetPartialWindowRed(const unsigned char* buffer_red, int x, int y, int w, int l) {
+    SendPartialData(DATA_START_TRANSMISSION_2, buffer_red, 0xFF, x, y, w, l);
+}
+
+template <class Panel>
+void BasicEpd<Panel>::SendPartialData(unsigned char command, const unsigned char* buffer, unsigned char fill, int x, int y, int w, int l) {
     SendCommand(PARTIAL_IN);
+    SendPartialWindow(x, y, w, l);
+    SendCommand(command);
+    if (buffer != NULL) {
+        for(int i = 0; i < w  / 8 * l; i++) {
+            SendData(buffer[i]);  
+        }  
+    } else {
+        for(int i = 0; i < w  / 8 * l; i++) {
+            SendData(fill);  
+        }  
+    }
+    SendCommand(PARTIAL_OUT);  
+}
+
+template <class Panel>
+void BasicEpd<Panel>::SendPartialPlane(unsigned char command, const unsigned char* buffer, int bit, int x, int y, int w, int l) {
+    SendCommand(PARTIAL_IN);
+    SendPartialWindow(x, y, w, l);
+    SendCommand(command);
+    SendPlane(buffer, bit, w / 8 * l);
+    SendCommand(PARTIAL_OUT);
+}
+
+/**
+ *  @brief: one bit plane of 8 pixels at 2 bits per pixel, the selected bit of every
+ *          pixel is gathered from the 16 bit word instead of testing pixel by pixel
+ */
+static inline unsigned char GrayPlane(unsigned char a, unsigned char b, int bit) {
+    unsigned int x = ((a << 8 | b) >> bit) & 0x5555;
+    x = (x | x >> 1) & 0x3333;
+    x = (x | x >> 2) & 0x0F0F;
+    x = (x | x >> 4) & 0x00FF;
+    return x;
+}
+
+/**
+ *  @brief: send count bytes of bit plane bit (1: high, 0: low) of a 2 bits per pixel buffer
+ */
+template <class Panel>
+void BasicEpd<Panel>::SendPlane(const unsigned char* buffer, int bit, int count) {
+    for (int i = 0; i < count; i++) {
+        SendData(GrayPlane(pgm_read_byte(&buffer[2 * i]), pgm_read_byte(&buffer[2 * i + 1]), bit));
+    }
+}
+
+/**
+ *  @brief: select the partial window used by the following data transmission / refresh
+ */
+template <class Panel>
+void BasicEpd<Panel>::SendPartialWindow(int x, int y, int w, int l) {
     SendCommand(PARTIAL_WINDOW);
     SendData(x >> 8);
     SendData(x & 0xf8);     // x should be the multiple of 8, the last 3 bit will always be ignored
@@ -119,56 +281,63 @@ void Epd::SetPartialWindow(const unsigned char* buffer_black, int x, int y, int
     SendData((y + l - 1) >> 8);        
     SendData((y + l - 1) & 0xff);
     SendData(0x01);         // Gates scan both inside and outside of the partial window. (default) 
-    DelayMs(2);
-    SendCommand(DATA_START_TRANSMISSION_2);
-    if (buffer_black != NULL) {
-        for(int i = 0; i < w  / 8 * l; i++) {
-            SendData(buffer_black[i]);  
-        }  
-    } else {
-        for(int i = 0; i < w  / 8 * l; i++) {
-            SendData(0x00);  
-        }  
+}
+
+/**
+ *  @brief: send a window of a full-size frame buffer (x and w multiples of 8)
+ */
+template <class Panel>
+void BasicEpd<Panel>::SendWindow(const unsigned char* frame_buffer, int x, int y, int w, int l) {
+    int stride = Panel::stride;
+    for (int j = y; j < y + l; j++) {
+        for (int i = x / 8; i < (x + w) / 8; i++) {
+            SendData(pgm_read_byte(&frame_buffer[j * stride + i]));
+        }
     }
-    DelayMs(2);
-    SendCommand(PARTIAL_OUT);  
 }
 
 /**
  *  @brief: set the look-up table
  */
-void Epd::SetLut(void) {
+template <class Panel>
+void BasicEpd<Panel>::SetLut(void) {
+    SetLut(Panel::bits_per_pixel == 2 ? lut_gray : lut_full);
+}
+
+template <class Panel>
+void BasicEpd<Panel>::SetLut(const EpdLut& lut) {
     unsigned int count;     
     SendCommand(LUT_FOR_VCOM);                            //vcom
     for(count = 0; count < 44; count++) {
-        SendData(lut_vcom0[count]);
+        SendData(lut.vcom[count]);
     }
     
     SendCommand(LUT_WHITE_TO_WHITE);                      //ww --
     for(count = 0; count < 42; count++) {
-        SendData(lut_ww[count]);
+        SendData(lut.ww[count]);
     }   
     
     SendCommand(LUT_BLACK_TO_WHITE);                      //bw r
     for(count = 0; count < 42; count++) {
-        SendData(lut_bw[count]);
+        SendData(lut.bw[count]);
     } 
 
     SendCommand(LUT_WHITE_TO_BLACK);                      //wb w
     for(count = 0; count < 42; count++) {
-        SendData(lut_bb[count]);
+        SendData(lut.wb[count]);
     } 
 
     SendCommand(LUT_BLACK_TO_BLACK);                      //bb b
     for(count = 0; count < 42; count++) {
-        SendData(lut_wb[count]);
+        SendData(lut.bb[count]);
     } 
 }
 
 /**
  * @brief: refresh and displays the frame
  */
-void Epd::DisplayFrame(const unsigned char* frame_buffer) {
+template <class Panel>
+void BasicEpd<Panel>::DisplayFrame(const unsigned char* frame_buffer) {
     SendCommand(RESOLUTION_SETTING);
     SendData(width >> 8);        
     SendData(width & 0xff);
@@ -181,30 +350,80 @@ void Epd::DisplayFrame(const unsigned char* frame_buffer) {
     SendCommand(VCOM_AND_DATA_INTERVAL_SETTING);
     SendCommand(0x97);    //VBDF 17|D7 VBDW 97  VBDB 57  VBDF F7  VBDW 77  VBDB 37  VBDR B7
 
-    if (frame_buffer != NULL) {
+    if (frame_buffer != NULL && Panel::bits_per_pixel == 2) {
+        SendCommand(DATA_START_TRANSMISSION_1);
+        SendPlane(frame_buffer, 1, width / 8 * height);
+        SendCommand(DATA_START_TRANSMISSION_2);
+        SendPlane(frame_buffer, 0, width / 8 * height);
+    } else if (frame_buffer != NULL) {
         SendCommand(DATA_START_TRANSMISSION_1);
-        for(int i = 0; i < width / 8 * height; i++) {
+        for(int i = 0; i < Panel::plane_size; i++) {
             SendData(0xFF);      // bit set: white, bit reset: black
         }
-        DelayMs(2);
         SendCommand(DATA_START_TRANSMISSION_2); 
-        for(int i = 0; i < width / 8 * height; i++) {
+        for(int i = 0; i < Panel::plane_size; i++) {
             SendData(pgm_read_byte(&frame_buffer[i]));
         }  
-        DelayMs(2);                  
     }
 
     SetLut();
 
     SendCommand(DISPLAY_REFRESH); 
-    DelayMs(100);
+    DelayMs(1);                     // BUSY goes low right after the command
     WaitUntilIdle();
 }
 
+/**
+ * @brief: refresh only the window x, y, w, l with the fast partial waveform.
+ *         previous has to hold the image currently shown on the panel, only pixels
+ *         that differ from it are driven. Both buffers are full-size frame buffers,
+ *         x and w have to be multiples of 8. Without buffers the window is refreshed
+ *         from what SetPartialWindowPrevious / SetPartialWindow put into the SRAM.
+ */
+template <class Panel>
+void BasicEpd<Panel>::DisplayFramePartial(const unsigned char* previous, const unsigned char* frame_buffer, int x, int y, int w, int l) {
+    if (!Panel::partial_lut) {
+        DisplayFrame(frame_buffer);
+        return;
+    }
+
+    SendCommand(RESOLUTION_SETTING);
+    SendData(width >> 8);        
+    SendData(width & 0xff);
+    SendData(height >> 8);
+    SendData(height & 0xff);
+
+    SendCommand(VCM_DC_SETTING);
+    SendData(0x12);                   
+
+    SendCommand(VCOM_AND_DATA_INTERVAL_SETTING);
+    SendData(0x17);                   // border floating, keeps the frame from flashing
+
+    SendCommand(PARTIAL_IN);
+    SendPartialWindow(x, y, w, l);
+
+    if (previous != NULL) {
+        SendCommand(DATA_START_TRANSMISSION_1);
+        SendWindow(previous, x, y, w, l);
+    }
+    if (frame_buffer != NULL) {
+        SendCommand(DATA_START_TRANSMISSION_2);
+        SendWindow(frame_buffer, x, y, w, l);
+    }
+
+    SetLut(lut_partial);
+
+    SendCommand(DISPLAY_REFRESH); 
+    DelayMs(1);                     // BUSY goes low right after the command
+    WaitUntilIdle();
+    SendCommand(PARTIAL_OUT);
+}
+
 /**
  * @brief: clear the frame data from the SRAM, this won't refresh the display
  */
-void Epd::ClearFrame(void) {
+template <class Panel>
+void BasicEpd<Panel>::ClearFrame(void) {
     SendCommand(RESOLUTION_SETTING);
     SendData(width >> 8);
     SendData(width & 0xff);
@@ -212,26 +431,25 @@ void Epd::ClearFrame(void) {
     SendData(height & 0xff);
 
     SendCommand(DATA_START_TRANSMISSION_1);           
-    DelayMs(2);
-    for(int i = 0; i < width / 8 * height; i++) {
+    for(int i = 0; i < Panel::plane_size; i++) {
         SendData(0xFF);  
     }  
-    DelayMs(2);
     SendCommand(DATA_START_TRANSMISSION_2);           
-    DelayMs(2);
-    for(int i = 0; i < width / 8 * height; i++) {
+    for(int i = 0; i < Panel::plane_size; i++) {
         SendData(0xFF);  
     }  
-    DelayMs(2);
 }
 
 /**
  * @brief: This displays the frame data from SRAM
  */
-void Epd::DisplayFrame(void) {
-    SetLut();
+template <class Panel>
+void BasicEpd<Panel>::DisplayFrame(void) {
+    if (Panel::full_lut) {
+        SetLut();
+    }
     SendCommand(DISPLAY_REFRESH); 
-    DelayMs(100);
+    DelayMs(1);                     // BUSY goes low right after the command
     WaitUntilIdle();
 }
 
@@ -241,25 +459,9 @@ void Epd::DisplayFrame(void) {
  *         check code, the command would be executed if check code = 0xA5. 
  *         You can use Epd::Reset() to awaken and use Epd::Init() to initialize.
  */
-void Epd::Sleep() {
-    SendCommand(VCOM_AND_DATA_INTERVAL_SETTING);
-    SendData(0x17);                       //border floating    
-    SendCommand(VCM_DC_SETTING);          //VCOM to 0V
-    SendCommand(PANEL_SETTING);
-    DelayMs(100);          
-
-    SendCommand(POWER_SETTING);           //VG&VS to 0V fast
-    SendData(0x00);        
-    SendData(0x00);        
-    SendData(0x00);              
-    SendData(0x00);        
-    SendData(0x00);
-    DelayMs(100);          
-                
-    SendCommand(POWER_OFF);          //power off
-    WaitUntilIdle();
-    SendCommand(DEEP_SLEEP);         //deep sleep
-    SendData(0xA5);
+template <class Panel>
+void BasicEpd<Panel>::Sleep() {
+    RunSequence(sleep_sequence);
 }
 
 const unsigned char lut_vcom0[] =
@@ -317,6 +519,117 @@ const unsigned char lut_wb[] ={
 };
 
 
+/* Fast waveform for partial updates: a single 14 frame phase that only drives
+ * pixels which change (ww / bb stay at ground), ~0.3s at the 50Hz frame rate. */
+const unsigned char lut_vcom0_partial[] =
+{
+0x00, 0x0E, 0x00, 0x00, 0x00, 0x01,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+const unsigned char lut_ww_partial[] ={
+0x00, 0x0E, 0x00, 0x00, 0x00, 0x01,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+const unsigned char lut_bw_partial[] ={
+0xA0, 0x0E, 0x00, 0x00, 0x00, 0x01,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+const unsigned char lut_wb_partial[] ={
+0x50, 0x0E, 0x00, 0x00, 0x00, 0x01,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+const unsigned char lut_bb_partial[] ={
+0x00, 0x0E, 0x00, 0x00, 0x00, 0x01,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+/* lut_bb is uploaded to WHITE_TO_BLACK and lut_wb to BLACK_TO_BLACK (both are identical) */
+const EpdLut lut_full = {lut_vcom0, lut_ww, lut_bw, lut_bb, lut_wb};
+const EpdLut lut_partial = {lut_vcom0_partial, lut_ww_partial, lut_bw_partial, lut_wb_partial, lut_bb_partial};
+
+/* 4 level gray. White and both grays start like lut_ww and end white, black starts
+ * like lut_bb and ends black. The last phase then drives towards black for 0 (WW,
+ * white, held at GND), 3 (WB, light gray), 8 (BW, dark gray) or 10 frames (BB,
+ * black). DTM1 holds the high bit of the level, DTM2 the low bit. The set is not
+ * temperature compensated. */
+const unsigned char lut_vcom0_gray[] =
+{
+0x00, 0x17, 0x00, 0x00, 0x00, 0x02,
+0x00, 0x17, 0x17, 0x00, 0x00, 0x02,
+0x00, 0x0A, 0x01, 0x00, 0x00, 0x01,
+0x00, 0x0E, 0x0E, 0x00, 0x00, 0x02,
+0x00, 0x0A, 0x00, 0x00, 0x00, 0x01,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+const unsigned char lut_ww_gray[] ={
+0x40, 0x17, 0x00, 0x00, 0x00, 0x02,
+0x90, 0x17, 0x17, 0x00, 0x00, 0x02,
+0x40, 0x0A, 0x01, 0x00, 0x00, 0x01,
+0xA0, 0x0E, 0x0E, 0x00, 0x00, 0x02,
+0x00, 0x0A, 0x00, 0x00, 0x00, 0x01,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+const unsigned char lut_wb_gray[] ={
+0x40, 0x17, 0x00, 0x00, 0x00, 0x02,
+0x90, 0x17, 0x17, 0x00, 0x00, 0x02,
+0x40, 0x0A, 0x01, 0x00, 0x00, 0x01,
+0xA0, 0x0E, 0x0E, 0x00, 0x00, 0x02,
+0x40, 0x03, 0x07, 0x00, 0x00, 0x01,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+const unsigned char lut_bw_gray[] ={
+0x40, 0x17, 0x00, 0x00, 0x00, 0x02,
+0x90, 0x17, 0x17, 0x00, 0x00, 0x02,
+0x40, 0x0A, 0x01, 0x00, 0x00, 0x01,
+0xA0, 0x0E, 0x0E, 0x00, 0x00, 0x02,
+0x40, 0x08, 0x02, 0x00, 0x00, 0x01,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+const unsigned char lut_bb_gray[] ={
+0x80, 0x17, 0x00, 0x00, 0x00, 0x02,
+0x90, 0x17, 0x17, 0x00, 0x00, 0x02,
+0x80, 0x0A, 0x01, 0x00, 0x00, 0x01,
+0x50, 0x0E, 0x0E, 0x00, 0x00, 0x02,
+0x40, 0x0A, 0x00, 0x00, 0x00, 0x01,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+const EpdLut lut_gray = {lut_vcom0_gray, lut_ww_gray, lut_bw_gray, lut_wb_gray, lut_bb_gray};
+
+template class BasicEpd<Panel4in2>;
+template class BasicEpd<Panel4in2Red>;
+template class BasicEpd<Panel4in2Gray>;
+
 
 /* END OF FILE */
 
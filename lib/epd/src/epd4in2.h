@@ -28,10 +28,7 @@
 #define EPD4IN2_H
 
 #include "epdif.h"
-
-// Display resolution
-#define EPD_WIDTH       400
-#define EPD_HEIGHT      300
+#include "epdpanel.h"
 
 // EPD4IN2 commands
 #define PANEL_SETTING                               0x00
@@ -79,34 +76,68 @@ extern const unsigned char lut_bw[];
 extern const unsigned char lut_bb[];
 extern const unsigned char lut_wb[];
 
-class Epd : EpdIf {
+extern const unsigned char lut_vcom0_partial[];
+extern const unsigned char lut_ww_partial[];
+extern const unsigned char lut_bw_partial[];
+extern const unsigned char lut_bb_partial[];
+extern const unsigned char lut_wb_partial[];
+
+/* One waveform set, in the order the tables are uploaded (0x20 - 0x24) */
+struct EpdLut {
+    const unsigned char* vcom;
+    const unsigned char* ww;
+    const unsigned char* bw;
+    const unsigned char* wb;
+    const unsigned char* bb;
+};
+
+extern const EpdLut lut_full;
+extern const EpdLut lut_partial;
+extern const EpdLut lut_gray;
+
+template <class Panel>
+class BasicEpd : EpdIf {
+    static_assert(Panel::full_lut || Panel::planes == 2, "no waveform for this panel in the 4.2inch driver");
+
 public:
-    unsigned int width;
-    unsigned int height;
+    static const int width = Panel::width;
+    static const int height = Panel::height;
 
-    Epd();
-    ~Epd();
+    BasicEpd();
+    ~BasicEpd();
     int  Init(void);
     void SendCommand(unsigned char command);
     void SendData(unsigned char data);
     void WaitUntilIdle(void);
     void Reset(void);
     void SetPartialWindow(const unsigned char* frame_buffer, int x, int y, int w, int l);
+    void SetPartialWindowPrevious(const unsigned char* previous, int x, int y, int w, int l);
     void SetPartialWindowBlack(const unsigned char* buffer_black, int x, int y, int w, int l);
     void SetPartialWindowRed(const unsigned char* buffer_red, int x, int y, int w, int l);
     void SetLut(void);
+    void SetLut(const EpdLut& lut);
     void DisplayFrame(const unsigned char* frame_buffer);
+    void DisplayFramePartial(const unsigned char* previous, const unsigned char* frame_buffer, int x, int y, int w, int l);
     void DisplayFrame(void);
     void ClearFrame(void);
     void Sleep(void);
 
 private:
+    void RunSequence(const unsigned char* sequence);
+    void SendPartialWindow(int x, int y, int w, int l);
+    void SendPartialData(unsigned char command, const unsigned char* buffer, unsigned char fill, int x, int y, int w, int l);
+    void SendPartialPlane(unsigned char command, const unsigned char* buffer, int bit, int x, int y, int w, int l);
+    void SendPlane(const unsigned char* buffer, int bit, int count);
+    void SendWindow(const unsigned char* frame_buffer, int x, int y, int w, int l);
+
     unsigned int reset_pin;
     unsigned int dc_pin;
     unsigned int cs_pin;
     unsigned int busy_pin;
 };
 
+typedef BasicEpd<Panel4in2> Epd;
+
 #endif /* EPD4IN2_H */
 
 /* END OF FILE */
@@ -25,6 +25,8 @@
  * THE SOFTWARE.
  */
 
+#ifdef ARDUINO
+
 #include <SPI.h>
 #include "epdif.h"
 
@@ -62,3 +64,4 @@ int EpdIf::IfInit(void) {
     return 0;
 }
 
+#endif /* ARDUINO */
@@ -28,7 +28,15 @@
 #ifndef EPDIF_H
 #define EPDIF_H
 
+#ifdef ARDUINO
 #include <arduino.h>
+#else
+/* Host build, see epdif_linux.cpp */
+#include <stddef.h>
+#define LOW             0
+#define HIGH            1
+#define pgm_read_byte(addr) (*(const unsigned char *)(addr))
+#endif
 
 // Pin definition
 #define RST_PIN         12
@@ -0,0 +1,42 @@
+/**
+ *  @filename   :   epdif_linux.cpp
+ *  @brief      :   EPD interface functions for host builds. Everything is
+ *                  forwarded to epd_recorder instead of GPIO / SPI, so the
+ *                  driver can be run and measured without hardware.
+ */
+
+#ifndef ARDUINO
+
+#include "epdif.h"
+#include "epdrecorder.h"
+
+EpdIf::EpdIf() {
+};
+
+EpdIf::~EpdIf() {
+};
+
+void EpdIf::DigitalWrite(int pin, int value) {
+    epd_recorder.Pin(pin, value);
+}
+
+int EpdIf::DigitalRead(int pin) {
+    if (pin == BUSY_PIN) {
+        return epd_recorder.Busy();
+    }
+    return LOW;
+}
+
+void EpdIf::DelayMs(unsigned int delaytime) {
+    epd_recorder.Delay(delaytime);
+}
+
+void EpdIf::SpiTransfer(unsigned char data) {
+    epd_recorder.Transfer(data);
+}
+
+int EpdIf::IfInit(void) {
+    return 0;
+}
+
+#endif /* ARDUINO */
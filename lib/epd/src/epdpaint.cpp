@@ -25,36 +25,47 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#ifdef ARDUINO
 #include <pgmspace.h>
+#else
+#include "epdif.h"
+#endif
 #include "epdpaint.h"
 
-Paint::Paint(unsigned char* image, int width, int height) {
+template <class Panel>
+BasicPaint<Panel>::BasicPaint(unsigned char* image, int width, int height) {
     this->rotate = ROTATE_0;
     this->image = image;
     /* 1 byte = 8 pixels, so the width should be the multiple of 8 */
     this->width = width % 8 ? width + 8 - (width % 8) : width;
+    this->stride = this->width * Panel::bits_per_pixel / 8;
     this->height = height;
+    this->offset_y = 0;
 }
 
-Paint::~Paint() {
+template <class Panel>
+BasicPaint<Panel>::BasicPaint(unsigned char* image) : BasicPaint(image, Panel::width, Panel::band_height) {
+}
+
+template <class Panel>
+BasicPaint<Panel>::~BasicPaint() {
 }
 
 /**
  *  @brief: clear the image
  */
-void Paint::Clear(int colored) {
-    for (int x = 0; x < this->width; x++) {
-        for (int y = 0; y < this->height; y++) {
-            DrawAbsolutePixel(x, y, colored);
-        }
-    }
+template <class Panel>
+void BasicPaint<Panel>::Clear(int colored) {
+    memset(image, Fill(colored), this->stride * this->height);
 }
 
 /**
  *  @brief: clear area of image
  */
-void Paint::ClearArea(int x, int y, int width, int height, int colored) {
+template <class Panel>
+void BasicPaint<Panel>::ClearArea(int x, int y, int width, int height, int colored) {
     for (int s = x; s < x + width && s < this->width; s++) {
         for (int t = y; t < y + height && t < this->height; t++) {
             DrawAbsolutePixel(x, y, colored);
@@ -62,84 +73,114 @@ void Paint::ClearArea(int x, int y, int width, int height, int colored) {
     }
 }
 
+/**
+ *  @brief: value of colored as it is stored in the image, and a byte filled with it
+ */
+template <class Panel>
+int BasicPaint<Panel>::Stored(int colored) {
+    return IF_INVERT_COLOR ? colored & white : (colored & white) ^ white;
+}
+
+template <class Panel>
+unsigned char BasicPaint<Panel>::Fill(int colored) {
+    return Stored(colored) * (Panel::bits_per_pixel == 1 ? 0xFF : 0x55);
+}
+
 /**
  *  @brief: this draws a pixel by absolute coordinates.
  *          this function won't be affected by the rotate parameter.
  */
-void Paint::DrawAbsolutePixel(int x, int y, int colored) {
+template <class Panel>
+void BasicPaint<Panel>::DrawAbsolutePixel(int x, int y, int colored) {
+    y -= this->offset_y;
     if (x < 0 || x >= this->width || y < 0 || y >= this->height) {
         return;
     }
-    if (IF_INVERT_COLOR) {
-        if (colored) {
-            image[(x + y * this->width) / 8] |= 0x80 >> (x % 8);
-        } else {
-            image[(x + y * this->width) / 8] &= ~(0x80 >> (x % 8));
-        }
-    } else {
-        if (colored) {
-            image[(x + y * this->width) / 8] &= ~(0x80 >> (x % 8));
-        } else {
-            image[(x + y * this->width) / 8] |= 0x80 >> (x % 8);
-        }
-    }
+    // pixels are packed msb first
+    int shift = 8 - Panel::bits_per_pixel - (x * Panel::bits_per_pixel) % 8;
+    unsigned char *p = &image[y * this->stride + x * Panel::bits_per_pixel / 8];
+    *p = (*p & ~(white << shift)) | (Stored(colored) << shift);
 }
 
-bool Paint::CheckPixel(int x, int y, int colored) {
-    // currently colored = 1 if blank / 0 if black
-    // IF_INVERT_COLOR is 1 for this
-
+/**
+ *  @brief: colored value of a pixel by absolute coordinates, -1 outside of the image
+ */
+template <class Panel>
+int BasicPaint<Panel>::GetPixel(int x, int y) {
+    y -= this->offset_y;
     if (x < 0 || y < 0 || x >= width || y >= height)
-        return false;
+        return -1;
 
-    // so if equal then check for blank
-    if (colored == IF_INVERT_COLOR) {
-        return (image[(x + y * this->width) / 8] & (0x80 >> (x % 8))) != 0;
-    } else {
-        return (image[(x + y * this->width) / 8] & (0x80 >> (x % 8))) == 0;
-    }
+    int shift = 8 - Panel::bits_per_pixel - (x * Panel::bits_per_pixel) % 8;
+    return Stored((image[y * this->stride + x * Panel::bits_per_pixel / 8] >> shift) & white);
+}
+
+template <class Panel>
+bool BasicPaint<Panel>::CheckPixel(int x, int y, int colored) {
+    return GetPixel(x, y) == (colored & white);
 }
 
 /**
  *  @brief: Getters and Setters
  */
-unsigned char* Paint::GetImage(void) {
+template <class Panel>
+unsigned char* BasicPaint<Panel>::GetImage(void) {
     return this->image;
 }
 
-int Paint::GetWidth(void) {
+template <class Panel>
+int BasicPaint<Panel>::GetWidth(void) {
     return this->width;
 }
 
-void Paint::SetWidth(int width) {
+template <class Panel>
+void BasicPaint<Panel>::SetWidth(int width) {
     this->width = width % 8 ? width + 8 - (width % 8) : width;
+    this->stride = this->width * Panel::bits_per_pixel / 8;
 }
 
-int Paint::GetHeight(void) {
+template <class Panel>
+int BasicPaint<Panel>::GetHeight(void) {
     return this->height;
 }
 
-void Paint::SetHeight(int height) {
+template <class Panel>
+void BasicPaint<Panel>::SetHeight(int height) {
     this->height = height;
 }
 
-int Paint::GetRotate(void) {
+template <class Panel>
+int BasicPaint<Panel>::GetOffsetY(void) {
+    return this->offset_y;
+}
+
+/**
+ *  @brief: image starts at row offset_y of the panel (band rendering),
+ *          all coordinates stay absolute
+ */
+template <class Panel>
+void BasicPaint<Panel>::SetOffsetY(int offset_y) {
+    this->offset_y = offset_y;
+}
+
+template <class Panel>
+int BasicPaint<Panel>::GetRotate(void) {
     return this->rotate;
 }
 
-void Paint::SetRotate(int rotate){
+template <class Panel>
+void BasicPaint<Panel>::SetRotate(int rotate){
     this->rotate = rotate;
 }
 
 /**
  *  @brief: this draws a pixel by the coordinates
  */
-void Paint::DrawPixel(int x, int y, int colored) {
+template <class Panel>
+void BasicPaint<Panel>::DrawPixel(int x, int y, int colored) {
     int point_temp;
     if (this->rotate == ROTATE_0) {
-        if(x < 0 || x >= this->width || y < 0 || y >= this->height) {
-            return;
-        }
+        // bounds are checked against the band in DrawAbsolutePixel
         DrawAbsolutePixel(x, y, colored);
     } else if (this->rotate == ROTATE_90) {
         if(x < 0 || x >= this->height || y < 0 || y >= this->width) {
@@ -170,7 +211,8 @@ void Paint::DrawPixel(int x, int y, int colored) {
 /**
  *  @brief: this draws a charactor on the frame buffer but not refresh
  */
-void Paint::DrawCharAt(int x, int y, char ascii_char, sFONT* font, int colored) {
+template <class Panel>
+void BasicPaint<Panel>::DrawCharAt(int x, int y, char ascii_char, sFONT* font, int colored) {
     int i, j;
     unsigned int char_offset = (ascii_char - ' ') * font->Height * (font->Width / 8 + (font->Width % 8 ? 1 : 0));
     const unsigned char* ptr = &font->table[char_offset];
@@ -193,7 +235,8 @@ void Paint::DrawCharAt(int x, int y, char ascii_char, sFONT* font, int colored)
 /**
 *  @brief: this displays a string on the frame buffer but not refresh
 */
-void Paint::DrawStringAt(int x, int y, const char* text, sFONT* font, int colored) {
+template <class Panel>
+void BasicPaint<Panel>::DrawStringAt(int x, int y, const char* text, sFONT* font, int colored) {
     const char* p_text = text;
     unsigned int counter = 0;
     int refcolumn = x;
@@ -213,7 +256,8 @@ void Paint::DrawStringAt(int x, int y, const char* text, sFONT* font, int colore
 /**
 *  @brief: this draws a line on the frame buffer
 */
-void Paint::DrawLine(int x0, int y0, int x1, int y1, int colored) {
+template <class Panel>
+void BasicPaint<Panel>::DrawLine(int x0, int y0, int x1, int y1, int colored) {
     int dx =  abs(x1-x0), sx = x0<x1 ? 1 : -1;
     int dy = -abs(y1-y0), sy = y0<y1 ? 1 : -1;
     int err = dx+dy, e2; /* error value e_xy */
@@ -230,7 +274,13 @@ void Paint::DrawLine(int x0, int y0, int x1, int y1, int colored) {
 /**
 *  @brief: this draws a horizontal line on the frame buffer
 */
-void Paint::DrawHorizontalLine(int x, int y, int line_width, int colored) {
+template <class Panel>
+void BasicPaint<Panel>::DrawHorizontalLine(int x, int y, int line_width, int colored) {
+    if (this->rotate == ROTATE_0) {
+        FillSpan(x, x + line_width, y, colored, false);
+        return;
+    }
+
     int i;
     for (i = x; i < x + line_width; i++) {
         DrawPixel(i, y, colored);
@@ -240,7 +290,8 @@ void Paint::DrawHorizontalLine(int x, int y, int line_width, int colored) {
 /**
 *  @brief: this draws a vertical line on the frame buffer
 */
-void Paint::DrawVerticalLine(int x, int y, int line_height, int colored) {
+template <class Panel>
+void BasicPaint<Panel>::DrawVerticalLine(int x, int y, int line_height, int colored) {
     int i;
     for (i = y; i < y + line_height; i++) {
         DrawPixel(x, i, colored);
@@ -250,7 +301,8 @@ void Paint::DrawVerticalLine(int x, int y, int line_height, int colored) {
 /**
 *  @brief: this draws a rectangle
 */
-void Paint::DrawRectangle(int x0, int y0, int x1, int y1, int colored) {
+template <class Panel>
+void BasicPaint<Panel>::DrawRectangle(int x0, int y0, int x1, int y1, int colored) {
     int min_x, min_y, max_x, max_y;
     min_x = x1 > x0 ? x0 : x1;
     max_x = x1 > x0 ? x1 : x0;
@@ -266,7 +318,8 @@ void Paint::DrawRectangle(int x0, int y0, int x1, int y1, int colored) {
 /**
 *  @brief: this draws a filled rectangle
 */
-void Paint::DrawFilledRectangle(int x0, int y0, int x1, int y1, int colored) {
+template <class Panel>
+void BasicPaint<Panel>::DrawFilledRectangle(int x0, int y0, int x1, int y1, int colored) {
     int min_x, min_y, max_x, max_y;
     int i;
     min_x = x1 > x0 ? x0 : x1;
@@ -274,34 +327,28 @@ void Paint::DrawFilledRectangle(int x0, int y0, int x1, int y1, int colored) {
     min_y = y1 > y0 ? y0 : y1;
     max_y = y1 > y0 ? y1 : y0;
     
-    for (i = min_x; i <= max_x; i++) {
-      DrawVerticalLine(i, min_y, max_y - min_y, colored);
+    // row by row, horizontal lines are filled a byte at a time
+    for (i = min_y; i < max_y; i++) {
+      DrawHorizontalLine(min_x, i, max_x - min_x + 1, colored);
     }
 }
 
-void Paint::InvertRectangle(int x0, int y0, int x1, int y1, int colored) {
+template <class Panel>
+void BasicPaint<Panel>::InvertRectangle(int x0, int y0, int x1, int y1, int colored) {
     int min_x, min_y, max_x, max_y;
     min_x = x1 > x0 ? x0 : x1;
     max_x = x1 > x0 ? x1 : x0;
     min_y = y1 > y0 ? y0 : y1;
     max_y = y1 > y0 ? y1 : y0;
 
-    // int x_1 = min_x + (8 - min_x % 8);
-    // int x_2 = max_x - max_x % 8;
-
     for (int y = min_y; y <= max_y; y++) {
-        // invert each bit
-        for (int x = min_x; x < max_x; x++) {
-            if (CheckPixel(x, y, 1)) {
-                DrawAbsolutePixel(x, y, 0);
-            } else {
-                DrawAbsolutePixel(x, y, 1);
-            }
-        }
+        // invert all bits, black <> white and dark <> light gray
+        FillSpan(min_x, max_x, y, colored, true);
     }
 }
 
-void Paint::DrawDitherRectangle(int x0, int y0, int x1, int y1, int colored) {
+template <class Panel>
+void BasicPaint<Panel>::DrawDitherRectangle(int x0, int y0, int x1, int y1, int colored) {
     int min_x, min_y, max_x, max_y;
     min_x = x1 > x0 ? x0 : x1;
     max_x = x1 > x0 ? x1 : x0;
@@ -326,7 +373,8 @@ void Paint::DrawDitherRectangle(int x0, int y0, int x1, int y1, int colored) {
 /**
 *  @brief: this draws a circle
 */
-void Paint::DrawCircle(int x, int y, int radius, int colored) {
+template <class Panel>
+void BasicPaint<Panel>::DrawCircle(int x, int y, int radius, int colored) {
     /* Bresenham algorithm */
     int x_pos = -radius;
     int y_pos = 0;
@@ -354,7 +402,8 @@ void Paint::DrawCircle(int x, int y, int radius, int colored) {
 /**
 *  @brief: this draws a filled circle
 */
-void Paint::DrawFilledCircle(int x, int y, int radius, int colored) {
+template <class Panel>
+void BasicPaint<Panel>::DrawFilledCircle(int x, int y, int radius, int colored) {
     /* Bresenham algorithm */
     int x_pos = -radius;
     int y_pos = 0;
@@ -381,7 +430,8 @@ void Paint::DrawFilledCircle(int x, int y, int radius, int colored) {
     } while(x_pos <= 0);
 }
 
-void Paint::DrawBuffer(const unsigned char *ptr, const int *info, int x, int y, int colored) {
+template <class Panel>
+void BasicPaint<Panel>::DrawBuffer(const unsigned char *ptr, const int *info, int x, int y, int colored) {
     int width = info[0], height = info[1], offset_x = info[2], offset_y = info[3];
     
     int i, j, p;
@@ -395,7 +445,8 @@ void Paint::DrawBuffer(const unsigned char *ptr, const int *info, int x, int y,
     }
 }
 
-void Paint::DrawBufferDouble(const unsigned char *ptr, const int *info, int x, int y, int colored) {
+template <class Panel>
+void BasicPaint<Panel>::DrawBufferDouble(const unsigned char *ptr, const int *info, int x, int y, int colored) {
     int width = info[0], height = info[1], offset_x = info[2], offset_y = info[3];
     
     int i, j, p;
@@ -410,7 +461,8 @@ void Paint::DrawBufferDouble(const unsigned char *ptr, const int *info, int x, i
     }
 }
 
-void Paint::DrawBufferOpaque(const unsigned char *ptr, const int *info, int x, int y, int colored) {
+template <class Panel>
+void BasicPaint<Panel>::DrawBufferOpaque(const unsigned char *ptr, const int *info, int x, int y, int colored) {
     int width = info[0], height = info[1], offset_x = info[2], offset_y = info[3];
     
     int i, j, p;
@@ -420,13 +472,14 @@ void Paint::DrawBufferOpaque(const unsigned char *ptr, const int *info, int x, i
             if ((ptr[p / 8] & (0x80 >> (p % 8))) == 0) {
                 DrawPixel(offset_x + x + i, offset_y + y + j, colored);
             } else {
-                DrawPixel(offset_x + x + i, offset_y + y + j, 1 - colored);
+                DrawPixel(offset_x + x + i, offset_y + y + j, colored ^ white);
             }
         }
     }
 }
 
-void Paint::DrawBufferAlpha(const unsigned char *ptr, const unsigned char *alpha, const int *info, int x, int y, int colored) {
+template <class Panel>
+void BasicPaint<Panel>::DrawBufferAlpha(const unsigned char *ptr, const unsigned char *alpha, const int *info, int x, int y, int colored) {
     int width = info[0], height = info[1], offset_x = info[2], offset_y = info[3];
     
     int i, j, p;
@@ -439,13 +492,14 @@ void Paint::DrawBufferAlpha(const unsigned char *ptr, const unsigned char *alpha
             if ((ptr[p / 8] & (0x80 >> (p % 8))) == 0) {
                 DrawPixel(offset_x + x + i, offset_y + y + j, colored);
             } else {
-                DrawPixel(offset_x + x + i, offset_y + y + j, 1 - colored);
+                DrawPixel(offset_x + x + i, offset_y + y + j, colored ^ white);
             }
         }
     }
 }
 
-void Paint::DrawBufferLimited(const unsigned char *ptr, int total_width, int s_x, int s_y, int width, int height, int x, int y, int colored) {
+template <class Panel>
+void BasicPaint<Panel>::DrawBufferLimited(const unsigned char *ptr, int total_width, int s_x, int s_y, int width, int height, int x, int y, int colored) {
     int i, j, c, p;
     for (j = 0; j < height; j++) {
         c = (s_y + j) * total_width;
@@ -459,7 +513,8 @@ void Paint::DrawBufferLimited(const unsigned char *ptr, int total_width, int s_x
     }
 }
 
-void Paint::DrawArrowUp(int x, int y, int size, int colored) {
+template <class Panel>
+void BasicPaint<Panel>::DrawArrowUp(int x, int y, int size, int colored) {
     int sx = x - size / 2;
     for (int i = 0; i < size; i++) {
         int h = (i > size / 2) ? size - i : i + 1;
@@ -467,6 +522,118 @@ void Paint::DrawArrowUp(int x, int y, int size, int colored) {
     }
 }
 
+/**
+ *  @brief: fill (or invert) the pixels x0 <= x < x1 of row y by absolute coordinates.
+ *          Only the partial bytes at both ends are masked, the bytes in between are
+ *          written whole (8 pixels at 1 bit, 4 pixels at 2 bits per pixel).
+ */
+template <class Panel>
+void BasicPaint<Panel>::FillSpan(int x0, int x1, int y, int colored, bool invert) {
+    y -= this->offset_y;
+    if (y < 0 || y >= this->height) return;
+    if (x0 < 0) x0 = 0;
+    if (x1 > this->width) x1 = this->width;
+    if (x0 >= x1) return;
+
+    unsigned char *row = image + y * this->stride;
+    unsigned char fill = Fill(colored);
+    int b0 = x0 * Panel::bits_per_pixel, b1 = x1 * Panel::bits_per_pixel - 1;    // bits, msb first
+    int i0 = b0 / 8, i1 = b1 / 8;
+    unsigned char head = 0xFF >> (b0 % 8);
+    unsigned char tail = 0xFF << (7 - b1 % 8);
+
+    if (i0 == i1) {
+        head &= tail;
+    }
+    row[i0] = invert ? row[i0] ^ head : (row[i0] & ~head) | (fill & head);
+    if (i0 == i1) return;
+
+    row[i1] = invert ? row[i1] ^ tail : (row[i1] & ~tail) | (fill & tail);
+    if (invert) {
+        for (int i = i0 + 1; i < i1; i++) {
+            row[i] ^= 0xFF;
+        }
+    } else {
+        memset(row + i0 + 1, fill, i1 - i0 - 1);
+    }
+}
+
+/**
+ *  @brief: copy an image of the same format (e.g. rendered by another BasicPaint),
+ *          white pixels are transparent. Works a source byte at a time: the mask of
+ *          non-white pixels is computed for the whole byte and merged into the two
+ *          destination bytes it overlaps. Not affected by the rotate parameter.
+ */
+template <class Panel>
+void BasicPaint<Panel>::DrawImage(const unsigned char *ptr, const int *info, int x, int y) {
+    const int bpp = Panel::bits_per_pixel, ppb = 8 / bpp;
+    int width = info[0], height = info[1];
+    int src_stride = width * bpp / 8;
+    x += info[2];
+    y += info[3];
+
+    for (int j = 0; j < height; j++) {
+        int dy = y + j - this->offset_y;
+        if (dy < 0 || dy >= this->height) continue;
+        unsigned char *row = image + dy * this->stride;
+
+        for (int k = 0; k < src_stride; k++) {
+            unsigned char s = pgm_read_byte(&ptr[j * src_stride + k]);
+            unsigned char m = s ^ Fill(white);
+            if (bpp == 2) {
+                m = (m | m >> 1) & 0x55;
+                m |= m << 1;
+            }
+            if (m == 0) continue;
+
+            int dx = x + k * ppb;
+            if (dx < 0 || dx + ppb > this->width) {
+                // clipped, pixel by pixel
+                for (int p = 0; p < ppb; p++) {
+                    int c = Stored((s >> (8 - bpp * (p + 1))) & white);
+                    if (c != white) DrawAbsolutePixel(dx + p, y + j, c);
+                }
+                continue;
+            }
+
+            int shift = (dx * bpp) % 8;
+            unsigned char *d = row + dx * bpp / 8;
+            d[0] = (d[0] & ~(m >> shift)) | ((s & m) >> shift);
+            if (shift != 0) {
+                d[1] = (d[1] & ~(m << (8 - shift))) | ((s & m) << (8 - shift));
+            }
+        }
+    }
+}
+
+/**
+ *  @brief: DrawImage at twice the size
+ */
+template <class Panel>
+void BasicPaint<Panel>::DrawImageDouble(const unsigned char *ptr, const int *info, int x, int y) {
+    const int bpp = Panel::bits_per_pixel;
+    int width = info[0], height = info[1];
+    int src_stride = width * bpp / 8;
+    x += info[2];
+    y += info[3];
+
+    for (int j = 0; j < height; j++) {
+        for (int i = 0; i < width; i++) {
+            int shift = 8 - bpp - (i * bpp) % 8;
+            int v = Stored((pgm_read_byte(&ptr[j * src_stride + i * bpp / 8]) >> shift) & white);
+            if (v == white) continue;
+            FillSpan(x + i * 2, x + i * 2 + 2, y + j * 2, v, false);
+            FillSpan(x + i * 2, x + i * 2 + 2, y + j * 2 + 1, v, false);
+        }
+    }
+}
+
+template class BasicPaint<Panel2in9>;
+template class BasicPaint<Panel4in2>;
+template class BasicPaint<Panel4in2Red>;
+template class BasicPaint<Panel4in2Gray>;
+template class BasicPaint<Panel7in5>;
+
 /* END OF FILE */
 
 
@@ -37,21 +37,32 @@
 #define IF_INVERT_COLOR     1
 
 #include "fonts.h"
+#include "epdpanel.h"
+
+template <class Panel>
+class BasicPaint {
+    static_assert(Panel::bits_per_pixel == 1 || Panel::bits_per_pixel == 2, "only 1 or 2 bits per pixel are supported");
 
-class Paint {
 public:
-    Paint(unsigned char* image, int width, int height);
-    ~Paint();
+    // colored is the pixel value: 0 / 1 at 1 bit per pixel, 4 gray levels at 2 bits
+    static const int white = (1 << Panel::bits_per_pixel) - 1;
+
+    BasicPaint(unsigned char* image, int width, int height);
+    BasicPaint(unsigned char* image);     // one band of the panel
+    ~BasicPaint();
     void Clear(int colored);
     void ClearArea(int x, int y, int width, int height, int colored);
     int  GetWidth(void);
     void SetWidth(int width);
     int  GetHeight(void);
     void SetHeight(int height);
+    int  GetOffsetY(void);
+    void SetOffsetY(int offset_y);
     int  GetRotate(void);
     void SetRotate(int rotate);
     unsigned char* GetImage(void);
     void DrawAbsolutePixel(int x, int y, int colored);
+    int  GetPixel(int x, int y);
     bool CheckPixel(int x, int y, int colored);
     void DrawPixel(int x, int y, int colored);
     void DrawCharAt(int x, int y, char ascii_char, sFONT* font, int colored);
@@ -71,14 +82,24 @@ public:
     void DrawBufferAlpha(const unsigned char *ptr, const unsigned char *alpha, const int *info, int x, int y, int colored);
     void DrawBufferLimited(const unsigned char *ptr, int total_width, int s_x, int s_y, int width, int height, int x, int y, int colored);
     void DrawArrowUp(int x, int y, int size, int colored);
+    void DrawImage(const unsigned char *ptr, const int *info, int x, int y);
+    void DrawImageDouble(const unsigned char *ptr, const int *info, int x, int y);
 
 private:
+    int  Stored(int colored);
+    unsigned char Fill(int colored);
+    void FillSpan(int x0, int x1, int y, int colored, bool invert);
+
     unsigned char* image;
     int width;
     int height;
+    int stride;
     int rotate;
+    int offset_y;
 };
 
+typedef BasicPaint<Panel4in2> Paint;
+
 #endif
 
 /* END OF FILE */
@@ -0,0 +1,62 @@
+/**
+ *  @filename   :   epdpanel.h
+ *  @brief      :   Compile-time descriptors of the supported Waveshare panels.
+ *                  The driver (BasicEpd) and the renderer (BasicPaint) are
+ *                  templated on these, so strides, plane and band sizes are
+ *                  constants for every panel.
+ */
+
+#ifndef EPDPANEL_H
+#define EPDPANEL_H
+
+template <int W, int H, int BPP, int PLANES, int BAND>
+struct PanelGeometry {
+    static const int width = W;                 // should be a multiple of 8
+    static const int height = H;
+    static const int bits_per_pixel = BPP;
+    static const int planes = PLANES;           // 2 for black / red panels
+
+    static const int stride = (W * BPP + 7) / 8;
+    static const int plane_size = stride * H;
+
+    // rows rendered at once when the frame does not fit into RAM
+    static const int band_height = BAND;
+    static const int band_size = stride * BAND;
+    static const int num_bands = (H + BAND - 1) / BAND;
+};
+
+/* 2.9inch, 128x296 */
+struct Panel2in9 : PanelGeometry<128, 296, 1, 1, 296> {
+    static const bool full_lut = false;         // needs its own driver (different command set)
+    static const bool partial_lut = false;
+};
+
+/* 4.2inch, 400x300 */
+struct Panel4in2 : PanelGeometry<400, 300, 1, 1, 300> {
+    static const bool full_lut = true;          // waveforms in epd4in2.cpp
+    static const bool partial_lut = true;
+};
+
+/* 4.2inch black / white / red, 400x300. Both planes are streamed in bands
+ * of 100 rows, 2 x 5000 bytes instead of one 15000 byte frame */
+struct Panel4in2Red : PanelGeometry<400, 300, 1, 2, 100> {
+    static const bool full_lut = false;         // waveform from OTP
+    static const bool partial_lut = false;
+};
+
+/* 4.2inch with the 4 level gray waveform, 2 bits per pixel (bit set: white).
+ * 30000 bytes per frame, rendered in three bands of 10000 bytes */
+struct Panel4in2Gray : PanelGeometry<400, 300, 2, 1, 100> {
+    static const bool full_lut = true;          // lut_gray in epd4in2.cpp
+    static const bool partial_lut = false;
+};
+
+/* 7.5inch, 640x384, rendered in four bands of 7680 bytes */
+struct Panel7in5 : PanelGeometry<640, 384, 1, 1, 96> {
+    static const bool full_lut = false;         // needs its own driver (different command set)
+    static const bool partial_lut = false;
+};
+
+#endif /* EPDPANEL_H */
+
+/* END OF FILE */
@@ -0,0 +1,216 @@
+/**
+ *  @filename   :   epdrecorder.cpp
+ *  @brief      :   Implements the host-side EPD controller stand-in
+ */
+
+#ifndef ARDUINO
+
+#include <stdio.h>
+#include <string.h>
+#include "epdrecorder.h"
+
+EpdRecorder epd_recorder;
+
+EpdRecorder::EpdRecorder() {
+    trace = false;
+    dc = LOW;
+    command = 0;
+    index = 0;
+    pll = 0x3c;
+    partial = false;
+    x0 = y0 = 0;
+    x1 = Panel4in2::width - 1;
+    y1 = Panel4in2::height - 1;
+    busy_ms = 0;
+    memset(ram, 0xFF, sizeof(ram));
+    memset(image, 0xFF, sizeof(image));
+    memset(lut_vcom, 0, sizeof(lut_vcom));
+    memset(window, 0, sizeof(window));
+    ResetStats();
+}
+
+void EpdRecorder::ResetStats(void) {
+    commands = 0;
+    data_bytes = 0;
+    busy_polls = 0;
+    delay_ms = 0;
+    refresh_ms = 0;
+    refreshes = 0;
+}
+
+/**
+ *  @brief: write the panel image as binary PBM (returns 0 on success)
+ */
+int EpdRecorder::WritePbm(const char* path) {
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) {
+        return -1;
+    }
+    fprintf(f, "P4\n%d %d\n", Panel4in2::width, Panel4in2::height);
+    for (unsigned int i = 0; i < sizeof(image); i++) {
+        fputc(~image[i] & 0xFF, f);     // PBM: bit set is black
+    }
+    fclose(f);
+    return 0;
+}
+
+/**
+ *  @brief: write the gray levels in RAM as binary PGM (DTM1: high bit, DTM2: low bit)
+ */
+int EpdRecorder::WritePgm(const char* path) {
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) {
+        return -1;
+    }
+    fprintf(f, "P5\n%d %d\n3\n", Panel4in2::width, Panel4in2::height);
+    for (int i = 0; i < Panel4in2::plane_size * 8; i++) {
+        int bit = 0x80 >> (i % 8);
+        fputc(((ram[0][i / 8] & bit) ? 2 : 0) + ((ram[1][i / 8] & bit) ? 1 : 0), f);
+    }
+    fclose(f);
+    return 0;
+}
+
+void EpdRecorder::Pin(int pin, int value) {
+    if (pin == DC_PIN) {
+        dc = value;
+    } else if (pin == RST_PIN && value == LOW) {
+        partial = false;
+        command = 0;
+        index = 0;
+        busy_ms = RECORDER_RESET_MS;
+    }
+}
+
+int EpdRecorder::Busy(void) {
+    if (busy_ms > 0) {
+        busy_polls++;
+        return 0;                       // 0: busy, 1: idle
+    }
+    return 1;
+}
+
+void EpdRecorder::Delay(unsigned int ms) {
+    if (trace && busy_ms == 0) {
+        printf("delay %u ms\n", ms);
+    }
+    delay_ms += ms;
+    busy_ms = busy_ms > ms ? busy_ms - ms : 0;
+}
+
+void EpdRecorder::Transfer(unsigned char data) {
+    if (dc == LOW) {
+        Command(data);
+    } else {
+        Data(data);
+    }
+}
+
+void EpdRecorder::Command(unsigned char c) {
+    if (trace && command != 0) {
+        printf("0x%02X, %d data bytes\n", command, index);
+    }
+
+    commands++;
+    command = c;
+    index = 0;
+
+    switch (command) {
+        case POWER_ON:
+            busy_ms = RECORDER_POWER_ON_MS;
+            break;
+        case POWER_OFF:
+            busy_ms = RECORDER_POWER_OFF_MS;
+            break;
+        case PARTIAL_IN:
+            partial = true;
+            break;
+        case PARTIAL_OUT:
+            partial = false;
+            break;
+        case DISPLAY_REFRESH:
+            Refresh();
+            break;
+    }
+}
+
+void EpdRecorder::Data(unsigned char data) {
+    data_bytes++;
+
+    if (command == DATA_START_TRANSMISSION_1 || command == DATA_START_TRANSMISSION_2) {
+        int stride = Panel4in2::stride;
+        int xs = partial ? x0 / 8 : 0;
+        int ys = partial ? y0 : 0;
+        int w = partial ? x1 / 8 - x0 / 8 + 1 : stride;
+        int y = ys + index / w;
+        int x = xs + index % w;
+        if (x < stride && y < Panel4in2::height) {
+            ram[command == DATA_START_TRANSMISSION_1 ? 0 : 1][y * stride + x] = data;
+        }
+    } else if (command == LUT_FOR_VCOM && index < (int)sizeof(lut_vcom)) {
+        lut_vcom[index] = data;
+    } else if (command == PLL_CONTROL && index == 0) {
+        pll = data;
+    } else if (command == PARTIAL_WINDOW && index < (int)sizeof(window)) {
+        window[index] = data;
+        if (index == 7) {
+            x0 = ((window[0] << 8) | window[1]) & ~0x07;
+            x1 = (window[2] << 8) | window[3];
+            y0 = (window[4] << 8) | window[5];
+            y1 = (window[6] << 8) | window[7];
+        }
+    }
+
+    index++;
+}
+
+/**
+ *  @brief: black / white mode, the pixels in the refreshed area end up as in DTM2
+ */
+void EpdRecorder::Refresh(void) {
+    int stride = Panel4in2::stride;
+    int xs = partial ? x0 / 8 : 0, xe = partial ? x1 / 8 : stride - 1;
+    int ys = partial ? y0 : 0, ye = partial ? y1 : Panel4in2::height - 1;
+
+    for (int y = ys; y <= ye && y < Panel4in2::height; y++) {
+        for (int x = xs; x <= xe && x < stride; x++) {
+            image[y * stride + x] = ram[1][y * stride + x];
+        }
+    }
+
+    unsigned long t = RefreshTime();
+    busy_ms = t;
+    refresh_ms += t;
+    refreshes++;
+
+    if (trace) {
+        printf("refresh %s, %lu ms\n", partial ? "partial" : "full", t);
+    }
+}
+
+/**
+ *  @brief: panel time of the uploaded VCOM waveform. Each of the 7 groups
+ *          holds 4 phase lengths (frames) and a repeat count.
+ */
+unsigned long EpdRecorder::RefreshTime(void) {
+    unsigned long frames = 0;
+    for (int group = 0; group < 7; group++) {
+        const unsigned char* g = &lut_vcom[group * 6];
+        frames += (unsigned long)(g[1] + g[2] + g[3] + g[4]) * g[5];
+    }
+
+    // frame rate from PLL_CONTROL, see Epd::Init
+    unsigned long hz = 50;
+    switch (pll) {
+        case 0x3a: hz = 100; break;
+        case 0x29: hz = 150; break;
+        case 0x39: hz = 200; break;
+        case 0x31: hz = 171; break;
+    }
+
+    return frames * 1000 / hz;
+}
+
+#endif /* ARDUINO */
+
+/* END OF FILE */
@@ -0,0 +1,70 @@
+/**
+ *  @filename   :   epdrecorder.h
+ *  @brief      :   Host-side stand-in for the EPD controller. Records what the
+ *                  driver sends through EpdIf (see epdif_linux.cpp), simulates
+ *                  the BUSY line from the uploaded waveform and keeps the image
+ *                  the panel would show.
+ */
+
+#ifndef EPDRECORDER_H
+#define EPDRECORDER_H
+
+#include "epd4in2.h"
+
+// Approximate BUSY times of the non-refresh operations (ms)
+#define RECORDER_RESET_MS           1
+#define RECORDER_POWER_ON_MS        40
+#define RECORDER_POWER_OFF_MS       20
+
+class EpdRecorder {
+public:
+    /* Statistics since the last ResetStats() */
+    unsigned long commands;
+    unsigned long data_bytes;
+    unsigned long busy_polls;       // reads of BUSY while the controller was busy
+    unsigned long delay_ms;         // simulated time spent in DelayMs, including BUSY waits
+    unsigned long refresh_ms;       // simulated panel time of all refreshes
+    unsigned long refreshes;
+
+    bool trace;                     // print every command and delay to stdout
+
+    /* What the panel shows, same layout as a frame buffer (bit set: white) */
+    unsigned char image[Panel4in2::plane_size];
+
+    EpdRecorder();
+    void ResetStats(void);
+    int  WritePbm(const char* path);
+    int  WritePgm(const char* path);
+
+    /* Called by the host implementation of EpdIf */
+    void Pin(int pin, int value);
+    int  Busy(void);
+    void Delay(unsigned int ms);
+    void Transfer(unsigned char data);
+
+private:
+    void Command(unsigned char command);
+    void Data(unsigned char data);
+    void Refresh(void);
+    unsigned long RefreshTime(void);
+
+    int dc;
+    unsigned char command;
+    int index;                      // data byte index within the current command
+
+    unsigned char ram[2][Panel4in2::plane_size];   // DTM1 (old), DTM2 (new)
+    unsigned char lut_vcom[44];
+    unsigned char pll;
+
+    bool partial;
+    unsigned char window[9];        // PARTIAL_WINDOW parameters
+    int x0, x1, y0, y1;             // active window in pixels (inclusive)
+
+    unsigned int busy_ms;
+};
+
+extern EpdRecorder epd_recorder;
+
+#endif /* EPDRECORDER_H */
+
+/* END OF FILE */
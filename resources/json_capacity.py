@@ -0,0 +1,74 @@
+import json
+import math
+from argparse import ArgumentParser
+
+# Fields WeatherAPI consumes, same as WeatherAPI::buildFilter (src/weather.cpp)
+FILTER = {
+    'currentWeather': {'time': True, 'icon': True, 'temperature': True},
+    'forecast': [{'dayDate': True, 'iconDay': True, 'temperatureMax': True, 'temperatureMin': True, 'precipitation': True}],
+    'graph': {
+        'start': True,
+        'startLowResolution': True,
+        'weatherIcon3h': True,
+        'temperatureMean1h': True,
+        'precipitation1h': True,
+        'precipitation10m': True,
+    },
+}
+
+# ArduinoJson 6 on the ESP32 (32 bit, ARDUINOJSON_USE_LONG_LONG): one slot per
+# array element or object member, strings copied once (keys are deduplicated)
+SLOT_SIZE = 16
+
+
+def apply_filter(value, flt):
+    if flt is True:
+        return value
+    if isinstance(flt, dict) and isinstance(value, dict):
+        return {k: apply_filter(v, flt[k]) for k, v in value.items() if k in flt}
+    if isinstance(flt, list) and isinstance(value, list):
+        return [apply_filter(v, flt[0]) for v in value]
+    return None
+
+
+def usage(value, strings):
+    if isinstance(value, dict):
+        size = 0
+        for k, v in value.items():
+            strings.add(k)
+            size += SLOT_SIZE + usage(v, strings)
+        return size
+    if isinstance(value, list):
+        return sum(SLOT_SIZE + usage(v, strings) for v in value)
+    if isinstance(value, str):
+        strings.add(value)
+    return 0
+
+
+def capacity(path, filtered):
+    with open(path) as f:
+        doc = json.load(f)
+    if filtered:
+        doc = apply_filter(doc, FILTER)
+
+    strings = set()
+    size = usage(doc, strings)
+    return size + sum(len(s.encode('utf-8')) + 1 for s in strings)
+
+
+if __name__ == '__main__':
+    parser = ArgumentParser(description='JsonDocument capacity needed for a corpus of weather responses')
+    parser.add_argument('responses', nargs='+', help='JSON responses of the weather service')
+    parser.add_argument('--unfiltered', action='store_true', help='without the filter document')
+    parser.add_argument('--margin', type=float, default=0.25, help='headroom on top of the largest response')
+    args = parser.parse_args()
+
+    peak = 0
+    for path in args.responses:
+        size = capacity(path, not args.unfiltered)
+        peak = max(peak, size)
+        print('%s: %d bytes' % (path, size))
+
+    # round up to 512 bytes
+    suggested = int(math.ceil(peak * (1 + args.margin) / 512) * 512)
+    print('peak %d bytes, JSON_CAPACITY %d' % (peak, suggested))
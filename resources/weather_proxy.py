@@ -0,0 +1,181 @@
+import json
+import math
+import struct
+import sys
+import time
+import ssl
+import subprocess
+import urllib.request
+from argparse import ArgumentParser
+from datetime import date
+from http.server import BaseHTTPRequestHandler, HTTPServer
+
+# Binary wire format of the weather, see include/weather.h (WIRE_VERSION)
+WIRE_VERSION = 1
+
+# fixed point of Weather (SCALE_TEMPERATURE, SCALE_PRECIPITATION)
+SCALE_TEMPERATURE = 10
+SCALE_PRECIPITATION = 10
+
+# resolution of the series in seconds
+STEP_3H = 10800
+STEP_1H = 3600
+STEP_10MIN = 600
+
+# how much is sent: the capacities of Weather (MAX_*) plus 3 hours the device rounds back
+HOURS = 51
+HOURS_10MIN = 19
+DAYS = 9
+
+
+def float32(value):
+    return struct.unpack('<f', struct.pack('<f', value))[0]
+
+
+def quantize(value, scale, low, high):
+    # same as quantize<T> on the device: roundf(value * scale) in single precision, saturated
+    if value is None:
+        value = 0
+    v = float32(float32(value) * scale)
+    v = math.floor(v + 0.5) if v >= 0 else -math.floor(-v + 0.5)
+    return max(low, min(high, v))
+
+
+def encode_series(values, start, step, now, count, fmt, scale, low, high):
+    # drop what is older than 3 hours, the device never looks at it. One more element
+    # than count as start is not aligned to the hours of the device
+    first = max(0, (now - STEP_3H - start) // step)
+    values = values[first:first + count + 1]
+
+    out = struct.pack('<IB', start + first * step, len(values))
+    for v in values:
+        out += struct.pack('<' + fmt, quantize(v, scale, low, high))
+    return out
+
+
+def encode(response, now=None):
+    current = response['currentWeather']
+    graph = response['graph']
+    if now is None:
+        now = int(time.time())
+
+    out = b'WXB' + struct.pack('<B', WIRE_VERSION)
+    out += struct.pack('<IBh', current['time'] // 1000, current['icon'],
+                       quantize(current['temperature'], SCALE_TEMPERATURE, -32768, 32767))
+
+    # from yesterday on, the device picks today in its time zone
+    yesterday = (now - 86400) // 86400
+    forecasts = []
+    for f in response['forecast']:
+        day = (date.fromisoformat(f['dayDate']) - date(1970, 1, 1)).days
+        if day < yesterday:
+            continue
+        forecasts.append(struct.pack('<HBhhH', day, f['iconDay'],
+                                     quantize(f['temperatureMax'], SCALE_TEMPERATURE, -32768, 32767),
+                                     quantize(f['temperatureMin'], SCALE_TEMPERATURE, -32768, 32767),
+                                     quantize(f['precipitation'], SCALE_PRECIPITATION, 0, 65535)))
+    forecasts = forecasts[:DAYS]
+    out += struct.pack('<B', len(forecasts)) + b''.join(forecasts)
+
+    start = graph['start'] // 1000
+    start_low = graph['startLowResolution'] // 1000
+    out += encode_series(graph['weatherIcon3h'], start, STEP_3H, now, (HOURS + 2) // 3, 'B', 1, 0, 255)
+    out += encode_series(graph['temperatureMean1h'], start, STEP_1H, now, HOURS, 'h', SCALE_TEMPERATURE, -32768, 32767)
+    out += encode_series(graph['precipitation1h'], start_low, STEP_1H, now, HOURS, 'B', SCALE_PRECIPITATION, 0, 255)
+    out += encode_series(graph['precipitation10m'], start, STEP_10MIN, now, HOURS_10MIN * 6, 'B', SCALE_PRECIPITATION, 0, 255)
+    return out
+
+
+class ProxyHandler(BaseHTTPRequestHandler):
+    upstream = ''
+    headers_upstream = {}
+    cache_time = 0
+    cache = {}
+    renderer = None
+    tz = 'UTC0'
+
+    def do_GET(self):
+        # the device asks for the same path as it would at the weather service
+        cached = self.cache.get(self.path)
+        if cached is None or time.time() - cached[0] > self.cache_time:
+            try:
+                request = urllib.request.Request(self.upstream + self.path, headers=self.headers_upstream)
+                with urllib.request.urlopen(request, timeout=20) as response:
+                    body = encode(json.load(response))
+            except Exception as e:
+                self.send_error(502, str(e))
+                return
+            cached = (time.time(), body)
+            self.cache[self.path] = cached
+
+        body = cached[1]
+        if self.renderer:
+            # thin clients get the frame rendered by host/render.cpp (USE_THIN_CLIENT)
+            rendered = subprocess.run([self.renderer, '0', self.tz], input=body, stdout=subprocess.PIPE)
+            if rendered.returncode != 0:
+                self.send_error(500, 'rendering failed')
+                return
+            body = rendered.stdout
+
+        self.send_response(200)
+        self.send_header('Content-Type', 'application/octet-stream')
+        self.send_header('Content-Length', str(len(body)))
+        self.send_header('Connection', 'close')
+        self.end_headers()
+        self.wfile.write(body)
+
+
+if __name__ == '__main__':
+    parser = ArgumentParser(description='Serves the weather in the binary wire format of the station')
+    parser.add_argument('--upstream', help='base URL of the weather service, e.g. https://test.weather.com')
+    parser.add_argument('--header', action='append', default=[], help='header sent upstream, "Name: value"')
+    parser.add_argument('--port', type=int, default=443)
+    parser.add_argument('--cert', help='certificate (PEM), the station connects with TLS')
+    parser.add_argument('--key', help='private key of the certificate (PEM)')
+    parser.add_argument('--psk', metavar='HEX', help='pre-shared key, the station connects with PSK-TLS (SERVER_PSK)')
+    parser.add_argument('--psk-identity', default='station', help='identity of the station (SERVER_PSK_IDENTITY)')
+    parser.add_argument('--cache', type=int, default=600, help='seconds an upstream response is reused')
+    parser.add_argument('--renderer', help='serve frames rendered by this build of host/render.cpp')
+    parser.add_argument('--tz', default='UTC0', help='POSIX time zone of the station, for --renderer')
+    parser.add_argument('--encode', metavar='JSON', help='encode a saved response to stdout and exit')
+    parser.add_argument('--now', type=int, help='current time for --encode (default: time of the response)')
+    args = parser.parse_args()
+
+    if args.encode:
+        with open(args.encode) as f:
+            response = json.load(f)
+        now = args.now if args.now else response['currentWeather']['time'] // 1000
+        body = encode(response, now)
+        sys.stdout.buffer.write(body)
+        print('%d bytes' % len(body), file=sys.stderr)
+        sys.exit(0)
+
+    if not args.upstream:
+        parser.error('--upstream is required to serve')
+
+    ProxyHandler.upstream = args.upstream.rstrip('/')
+    ProxyHandler.headers_upstream = dict(h.split(': ', 1) for h in args.header)
+    ProxyHandler.cache_time = args.cache
+    ProxyHandler.renderer = args.renderer
+    ProxyHandler.tz = args.tz
+
+    if args.psk and args.cert:
+        parser.error('--psk and --cert exclude each other')
+    if args.psk and not hasattr(ssl.SSLContext, 'set_psk_server_callback'):
+        parser.error('--psk needs Python 3.13 or later')
+
+    server = HTTPServer(('', args.port), ProxyHandler)
+    if args.cert:
+        context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        context.load_cert_chain(args.cert, args.key)
+        server.socket = context.wrap_socket(server.socket, server_side=True)
+    elif args.psk:
+        # TLS 1.2 with plain PSK key exchange (no certificate, no ECDHE), as offered by the station
+        psk = bytes.fromhex(args.psk)
+        context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        context.maximum_version = ssl.TLSVersion.TLSv1_2
+        context.set_ciphers('kPSK')
+        context.set_psk_server_callback(lambda identity: psk if identity == args.psk_identity else b'')
+        server.socket = context.wrap_socket(server.socket, server_side=True)
+    print('serving on port %d' % args.port)
+    server.serve_forever()
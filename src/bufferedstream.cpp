@@ -0,0 +1,82 @@
+#include "bufferedstream.h"
+
+size_t BlockClient::readBytes(char *buf, size_t size) {
+  size_t count = 0;
+  unsigned long start = millis();
+
+  while (count < size) {
+    int n = read(reinterpret_cast<uint8_t *>(buf) + count, size - count);
+    if (n > 0) {
+      count += n;
+      continue;
+    }
+    if (!connected() || millis() - start >= _timeout) break;
+    delay(1);
+  }
+  return count;
+}
+
+void BufferedStream::reset() {
+  position = 0;
+  length = 0;
+  bytes = 0;
+  calls = 0;
+  fills = 0;
+}
+
+// one bulk read of what the client has (at most the buffer), false if nothing arrived yet
+bool BufferedStream::fill() {
+  if (position < length) {
+    return true;
+  }
+
+  position = 0;
+  length = 0;
+
+  if (client.available() <= 0) {
+    return false;
+  }
+  int read = client.read(buffer, sizeof(buffer));
+  fills++;
+  if (read <= 0) {
+    return false;
+  }
+  length = read;
+  return true;
+}
+
+int BufferedStream::available() {
+  if (position < length) {
+    return length - position;
+  }
+  return client.available();
+}
+
+int BufferedStream::read() {
+  calls++;
+  if (!fill()) {
+    return -1;
+  }
+  bytes++;
+  return buffer[position++];
+}
+
+int BufferedStream::read(uint8_t *buf, size_t size) {
+  calls++;
+  if (!fill()) {
+    return -1;
+  }
+
+  size_t n = length - position < size ? length - position : size;
+  memcpy(buf, buffer + position, n);
+  position += n;
+  bytes += n;
+  return n;
+}
+
+int BufferedStream::peek() {
+  if (!fill()) {
+    return -1;
+  }
+  return buffer[position];
+}
@@ -0,0 +1,303 @@
+#include <ctype.h>
+
+#include "civiltime.h"
+
+namespace Civil
+{
+  // start or end of DST: Mm.w.d (day d of week w of month m), Jn (julian day, no leap day) or n
+  typedef enum ruleType {
+    RMonth,
+    RJulian,
+    RDay
+  } RuleType;
+
+  struct Rule {
+    RuleType type;
+    uint8_t month;
+    uint8_t week;
+    uint8_t weekday;
+    uint16_t day;
+    int32_t time; // seconds after local midnight
+  };
+
+  struct Zone {
+    int32_t std_offset; // seconds east of UTC
+    int32_t dst_offset;
+    bool has_dst;
+    Rule start, end;
+
+    // transitions of cached_year in UTC, computed once per year asked for
+    int cached_year;
+    int64_t dst_start, dst_end;
+  };
+
+  static Zone zone = {0, 0, false};
+
+  static int64_t floorDiv(int64_t a, int64_t b)
+  {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+  }
+
+  static bool isLeap(int year)
+  {
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+  }
+
+  static int daysInMonth(int year, int month)
+  {
+    static const uint8_t days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return month == 2 && isLeap(year) ? 29 : days[month - 1];
+  }
+
+  // H. Hinnant, chrono-compatible low-level date algorithms
+  int32_t daysFromCivil(int year, int month, int day)
+  {
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yoe = year - era * 400;
+    int doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+  }
+
+  void civilFromDays(int32_t days, int &year, int &month, int &day)
+  {
+    days += 719468;
+    int era = (days >= 0 ? days : days - 146096) / 146097;
+    int doe = days - era * 146097;
+    int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int mp = (5 * doy + 2) / 153;
+    day = doy - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = yoe + era * 400 + (month <= 2);
+  }
+
+  int weekday(int32_t days)
+  {
+    // 1970-01-01 was a thursday
+    int64_t d = static_cast<int64_t>(days) + 4;
+    return static_cast<int>(d - floorDiv(d, 7) * 7);
+  }
+
+  static bool parseNumber(const char *&str, int digits, int &value)
+  {
+    value = 0;
+    for (int i = 0; i < digits; i++) {
+      if (!isdigit(str[i])) return false;
+      value = value * 10 + (str[i] - '0');
+    }
+    str += digits;
+    return true;
+  }
+
+  bool parseDate(const char *str, int32_t *days)
+  {
+    int year, month, day;
+    if (str == NULL) return false;
+    if (!parseNumber(str, 4, year) || *str++ != '-') return false;
+    if (!parseNumber(str, 2, month) || *str++ != '-') return false;
+    if (!parseNumber(str, 2, day) || *str != 0) return false;
+    if (month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month)) return false;
+
+    *days = daysFromCivil(year, month, day);
+    return true;
+  }
+
+  // unsigned number of up to 3 digits
+  static bool parseInt(const char *&str, int &value)
+  {
+    if (!isdigit(*str)) return false;
+    value = 0;
+    for (int i = 0; i < 3 && isdigit(*str); i++) {
+      value = value * 10 + (*str++ - '0');
+    }
+    return true;
+  }
+
+  // [+|-]hh[:mm[:ss]] in seconds
+  static bool parseTime(const char *&str, int32_t &seconds)
+  {
+    int sign = 1, value;
+    if (*str == '+' || *str == '-') {
+      sign = *str++ == '-' ? -1 : 1;
+    }
+    if (!parseInt(str, value)) return false;
+    seconds = value * 3600;
+
+    for (int factor = 60; factor >= 1 && *str == ':'; factor /= 60) {
+      str++;
+      if (!parseInt(str, value)) return false;
+      seconds += value * factor;
+    }
+    seconds *= sign;
+    return true;
+  }
+
+  // name of the zone, alphabetic or quoted in <>
+  static bool parseName(const char *&str)
+  {
+    const char *begin = str;
+    if (*str == '<') {
+      while (*str && *str != '>') str++;
+      if (*str++ != '>') return false;
+      return str - begin >= 5;
+    }
+    while (isalpha(*str)) str++;
+    return str - begin >= 3;
+  }
+
+  static bool parseRule(const char *&str, Rule &rule)
+  {
+    int value;
+    if (*str == 'M') {
+      int week, day;
+      str++;
+      if (!parseInt(str, value) || *str++ != '.') return false;
+      if (!parseInt(str, week) || *str++ != '.') return false;
+      if (!parseInt(str, day)) return false;
+      if (value < 1 || value > 12 || week < 1 || week > 5 || day > 6) return false;
+      rule.type = RMonth;
+      rule.month = value;
+      rule.week = week;
+      rule.weekday = day;
+    } else {
+      rule.type = *str == 'J' ? RJulian : RDay;
+      if (*str == 'J') str++;
+      if (!parseInt(str, value) || value > 365 || (rule.type == RJulian && value < 1)) return false;
+      rule.day = value;
+    }
+
+    rule.time = 2 * 3600;
+    if (*str == '/') {
+      str++;
+      return parseTime(str, rule.time);
+    }
+    return true;
+  }
+
+  bool setZone(const char *tz)
+  {
+    Zone parsed = {0, 0, false};
+    const char *str = tz;
+
+    bool valid = str != NULL && parseName(str) && parseTime(str, parsed.std_offset);
+
+    // POSIX offsets are west of UTC
+    parsed.std_offset = -parsed.std_offset;
+
+    if (valid && *str) {
+      parsed.has_dst = true;
+      valid = parseName(str);
+
+      parsed.dst_offset = parsed.std_offset + 3600;
+      if (valid && *str && *str != ',') {
+        valid = parseTime(str, parsed.dst_offset);
+        parsed.dst_offset = -parsed.dst_offset;
+      }
+
+      if (valid && *str == ',') {
+        str++;
+        valid = parseRule(str, parsed.start) && *str++ == ',' && parseRule(str, parsed.end) && *str == 0;
+      } else if (valid) {
+        // no rules, same default as newlib (US rules)
+        parsed.start = {RMonth, 3, 2, 0, 0, 2 * 3600};
+        parsed.end = {RMonth, 11, 1, 0, 0, 2 * 3600};
+        valid = *str == 0;
+      }
+    }
+
+    if (!valid) {
+      zone = {0, 0, false};
+      return false;
+    }
+
+    parsed.cached_year = -1;
+    zone = parsed;
+    return true;
+  }
+
+  // local midnight of the day rule falls on in year, in days since 1970-01-01
+  static int32_t ruleDay(const Rule &rule, int year)
+  {
+    if (rule.type == RJulian) {
+      // february 29 is never counted
+      int day = rule.day - 1;
+      if (isLeap(year) && day >= 59) day++;
+      return daysFromCivil(year, 1, 1) + day;
+    }
+    if (rule.type == RDay) {
+      return daysFromCivil(year, 1, 1) + rule.day;
+    }
+
+    // first wanted weekday of the month, then forward to the week (5 = last)
+    int32_t first = daysFromCivil(year, rule.month, 1);
+    int day = (rule.weekday - weekday(first) + 7) % 7 + (rule.week - 1) * 7;
+    while (day >= daysInMonth(year, rule.month)) day -= 7;
+    return first + day;
+  }
+
+  int32_t utcOffset(time_t utc)
+  {
+    if (!zone.has_dst) {
+      return zone.std_offset;
+    }
+
+    int64_t local_std = static_cast<int64_t>(utc) + zone.std_offset;
+    int year, month, day;
+    civilFromDays(static_cast<int32_t>(floorDiv(local_std, SECONDS_PER_DAY)), year, month, day);
+
+    if (year != zone.cached_year) {
+      // start is given in standard time, end in daylight saving time
+      zone.dst_start = static_cast<int64_t>(ruleDay(zone.start, year)) * SECONDS_PER_DAY + zone.start.time - zone.std_offset;
+      zone.dst_end = static_cast<int64_t>(ruleDay(zone.end, year)) * SECONDS_PER_DAY + zone.end.time - zone.dst_offset;
+      zone.cached_year = year;
+    }
+
+    bool dst;
+    if (zone.dst_start < zone.dst_end) {
+      dst = utc >= zone.dst_start && utc < zone.dst_end;
+    } else {
+      // southern hemisphere, DST over new year
+      dst = utc >= zone.dst_start || utc < zone.dst_end;
+    }
+    return dst ? zone.dst_offset : zone.std_offset;
+  }
+
+  DateTime local(time_t utc)
+  {
+    int64_t local = static_cast<int64_t>(utc) + utcOffset(utc);
+    int32_t days = static_cast<int32_t>(floorDiv(local, SECONDS_PER_DAY));
+    int32_t seconds = static_cast<int32_t>(local - static_cast<int64_t>(days) * SECONDS_PER_DAY);
+
+    int year, month, day;
+    civilFromDays(days, year, month, day);
+
+    DateTime dt;
+    dt.days = days;
+    dt.year = year;
+    dt.month = month;
+    dt.day = day;
+    dt.hour = seconds / 3600;
+    dt.minute = seconds / 60 % 60;
+    dt.second = seconds % 60;
+    dt.weekday = weekday(days);
+    return dt;
+  }
+
+  time_t floorLocal(time_t utc, int32_t seconds)
+  {
+    int32_t offset = utcOffset(utc);
+    int64_t local = static_cast<int64_t>(utc) + offset;
+    local = floorDiv(local, seconds) * seconds;
+
+    // the floored local time may be on the other side of a DST change, convert it back
+    // with the offset there. A local time skipped by the change ends up right after it.
+    int64_t result = local - offset;
+    int32_t result_offset = utcOffset(static_cast<time_t>(result));
+    if (result_offset != offset && local - result_offset <= utc) {
+      result = local - result_offset;
+    }
+    return static_cast<time_t>(result);
+  }
+}
@@ -1,4 +1,5 @@
 #include "display.h"
+#include "civiltime.h"
 #include "data.h"
 
 #define Y_CURVES 100
@@ -6,7 +7,18 @@
 
 #define LABEL_OFFSET 35
 #define COLORED     0
-#define UNCOLORED   1
+#define UNCOLORED   BasicPaint<DisplayPanel>::white
+
+// gray levels of 2 bit panels, black on 1 bit panels
+#define DARK_GRAY   (DisplayPanel::bits_per_pixel == 2 ? 1 : COLORED)
+#define LIGHT_GRAY  (DisplayPanel::bits_per_pixel == 2 ? 2 : COLORED)
+
+#define ICON_STRIDE (56 * DisplayPanel::bits_per_pixel / 8)
+#define FRAME_TIMEOUT 5000 // ms without data before giving up on a frame
+
+// 11 icons and 33 hours of precipitation across the top, 7 of them in 10 minute steps,
+// today and 5 days at the bottom
+const Horizon Display::horizon = {33, 7, 6};
 
 static char buffer[2+1];
 char* dayShortStr(uint8_t day) {
@@ -35,12 +47,18 @@ bool Display::initialize(bool clear_buffer) {
     if (clear_buffer) epd.ClearFrame();
 
     // create buffer
-    buffer = new unsigned char[width * height / 8];
-    paint = new Paint(buffer, width, height);
+    buffer = new unsigned char[DisplayPanel::band_size];
+    paint = new BasicPaint<DisplayPanel>(buffer);
     paint->Clear(UNCOLORED);
 
-    icon_buffer = new unsigned char[56 * 48 / 8];
-    paint_icon = new Paint(icon_buffer, 56, 48);
+    if (DisplayPanel::planes == 2) {
+        buffer_red = new unsigned char[DisplayPanel::band_size];
+        paint_red = new BasicPaint<DisplayPanel>(buffer_red);
+        paint_red->Clear(UNCOLORED);
+    }
+
+    icon_buffer = new unsigned char[ICON_STRIDE * 48];
+    paint_icon = new BasicPaint<DisplayPanel>(icon_buffer, 56, 48);
     paint_icon->Clear(UNCOLORED);
 
     initialized = true;
@@ -109,7 +127,13 @@ void Display::renderIcon(uint8_t icon_type, int x, int y, bool scale_2 = false)
     bool is_dark_cloud = ((icon_type >= 4 && icon_type <= 11) || (icon_type >= 13 && icon_type <= 25) || icon_type == 33 || icon_type == 34);
     if (is_dark_cloud) {
         // draw background pattern for cloud first - align cloud bottom right
-        paint_icon->DrawBuffer(CLOUD_DARK, CLOUD_DARK_INFO, basic_info[2] + basic_info[0] - CLOUD_DARK_INFO[0], basic_info[3] + basic_info[1] - CLOUD_DARK_INFO[1], COLORED);
+        int cloud_x = basic_info[2] + basic_info[0] - CLOUD_DARK_INFO[0];
+        int cloud_y = basic_info[3] + basic_info[1] - CLOUD_DARK_INFO[1];
+        paint_icon->DrawBuffer(CLOUD_DARK, CLOUD_DARK_INFO, cloud_x, cloud_y, DARK_GRAY);
+        if (DisplayPanel::bits_per_pixel == 2) {
+            // the pattern is a checkerboard, shifted by one it fills the cloud with real gray
+            paint_icon->DrawBuffer(CLOUD_DARK, CLOUD_DARK_INFO, cloud_x + 1, cloud_y, DARK_GRAY);
+        }
     }
 
     // Draw template according to type
@@ -135,18 +159,20 @@ void Display::renderIcon(uint8_t icon_type, int x, int y, bool scale_2 = false)
         paint_icon->DrawBuffer(FOG_BOTTOM, FOG_BOTTOM_INFO, 0, 0, COLORED);
     }
 
-    static unsigned char zero[7] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    // blank rows are white at every bit depth
+    static unsigned char zero[ICON_STRIDE];
+    memset(zero, 0xFF, ICON_STRIDE);
 
     int top_y = 0, bottom_y = 0;
     while(top_y < 48) {
 
-        if (memcmp(zero, icon_buffer + top_y * 7 * sizeof(char), 7) != 0) {
+        if (memcmp(zero, icon_buffer + top_y * ICON_STRIDE, ICON_STRIDE) != 0) {
             break;
         }
         top_y++;
     }
     while(bottom_y < 48) {
-        if (memcmp(zero, icon_buffer + (47-bottom_y) * 7 * sizeof(char), 7) != 0) {
+        if (memcmp(zero, icon_buffer + (47-bottom_y) * ICON_STRIDE, ICON_STRIDE) != 0) {
             break;
         }
         bottom_y++;
@@ -157,9 +183,9 @@ void Display::renderIcon(uint8_t icon_type, int x, int y, bool scale_2 = false)
     int info[] = {56,48,0,0};
 
     if (scale_2) {
-        paint->DrawBufferDouble(icon_buffer, info, x, y + offset_y, COLORED);
+        paint->DrawImageDouble(icon_buffer, info, x, y + offset_y);
     } else {
-        paint->DrawBuffer(icon_buffer, info, x, y + offset_y, COLORED);
+        paint->DrawImage(icon_buffer, info, x, y + offset_y);
     }
 }
 
@@ -286,13 +312,13 @@ void Display::getPrecipitation(uint8_t icon_type, const int **info, const unsign
 
 void Display::renderWeatherForecast(const WeatherForecast *forecasts, int num_forecasts)
 {
-    for (int i = 0; i < num_forecasts - 1; i++) {
+    for (int i = 0; i < num_forecasts - 1 && 80 * (i + 1) <= width; i++) {
         int x = 80 * i;
         WeatherForecast f = forecasts[i + 1];
         renderIcon(f.icon, x + 15, 206);
 
-        int tempMin = roundf(f.tempMin);
-        int tempMax = roundf(f.tempMax);
+        int tempMin = roundf(f.tempMin());
+        int tempMax = roundf(f.tempMax());
 
         const char *c_1 = String(tempMin, DEC).c_str();
         const char *c_2 = "|";
@@ -313,28 +339,32 @@ void Display::renderPrecipitation(const Weather &weather, int start_hour, int of
     int hour, i_part = 0;
     float y_max = 1.f;
 
-    // offset hour only plays a role if > 3 (last update older than 3 hours. should not happen)
-    // in this case we just move everything forward 3h
-    offset_hour = offset_hour / 3;
+    // the chart starts with the 3 hour slot of the icons, older data (no update for a while) is skipped
+    int shift = slotOffset(offset_hour);
 
     int offset = 11;
 
     // precipitation 1h starts in the future at start_low. go forward skipping period (0 - 6AM)
-    int offset_low_h = (weather.start_low - weather.start) / 3600;
+    int offset_low_h = (weather.precipitation_1h.start - weather.start) / 3600;
+
+    // 10MIN section, up to the 1h series but not longer than the layout shows
+    int first_10min = shift * 6;
+    int num_10min = offset_low_h * 6;
+    if (num_10min > first_10min + horizon.steps10min()) num_10min = first_10min + horizon.steps10min();
+    if (num_10min > weather.precipitation_10min.length) num_10min = weather.precipitation_10min.length;
 
-    // 10MIN section
     int bar_width = 3;
 
-    for (int i = offset_hour * 3; i < offset_low_h * 6 && i_part < (width - 2*offset); i++) {
+    for (int i = first_10min; i < num_10min && i_part < (width - 2*offset); i++) {
 
-        hour = start_hour + i / 6;
+        hour = start_hour + (i - first_10min) / 6;
         hour = hour % 24;
         if (hour < HOUR_START) continue;
 
-        if (weather.precipitation10min[i] > 0) {
+        if (weather.precipitation_10min[i] > 0) {
             int x = offset + i_part;
-            int y0 = 20.f * fminf(weather.precipitation10min[i] / y_max, y_max);
-            paint->DrawFilledRectangle(x, 72 - y0, x + bar_width - 2, 72, COLORED);
+            int y0 = 20.f * fminf(weather.precipitation10min(i) / y_max, y_max);
+            paint->DrawFilledRectangle(x, 72 - y0, x + bar_width - 2, 72, DARK_GRAY);
         }
 
         i_part += bar_width;
@@ -343,15 +373,17 @@ void Display::renderPrecipitation(const Weather &weather, int start_hour, int of
     // 1H section
     bar_width = 3 * 6;
 
-    for (int i = offset_hour * 3; i < NUM_1H && i_part < (width - 2*offset); i++)
+    int first_1h = shift > offset_low_h ? shift - offset_low_h : 0;
+
+    for (int i = first_1h; i < weather.precipitation_1h.length && i_part < (width - 2*offset); i++)
     {
-        hour = (start_hour + offset_low_h + i) % 24;
+        hour = (start_hour + offset_low_h - shift + i) % 24;
         if (hour < HOUR_START) continue;
 
-        if (weather.precipitation1h[i] > 0) {
+        if (weather.precipitation_1h[i] > 0) {
             int x = offset + i_part;
-            int y0 = 20.f * fminf(weather.precipitation1h[i] / y_max, y_max);
-            paint->DrawFilledRectangle(x, 72 - y0, x + bar_width - 2, 72, COLORED);
+            int y0 = 20.f * fminf(weather.precipitation1h(i) / y_max, y_max);
+            paint->DrawFilledRectangle(x, 72 - y0, x + bar_width - 2, 72, DARK_GRAY);
         }
 
         i_part += bar_width;
@@ -362,7 +394,7 @@ void Display::renderPrecipitation(const Weather &weather, int start_hour, int of
 
 void Display::render24hIcons(const Weather &weather, int num_steps, int start_hour, int offset_hour)
 {
-    int start_i = offset_hour / 3;
+    int start_i = slotOffset(offset_hour) / 3;
 
     int part = 54;
     int offset = (width - 7 * part) / 2;
@@ -387,8 +419,8 @@ void Display::render24hIcons(const Weather &weather, int num_steps, int start_ho
 
 void Display::renderTodayOverview(const WeatherForecast &forecast, time_t start)
 {
-    struct tm start_tm = *localtime(&start);
-    String date(String(dayShortStr(start_tm.tm_wday + 1)) + ", " + String(start_tm.tm_mday) + ". " + String(monthNames[start_tm.tm_mon]));
+    Civil::DateTime start_dt = Civil::local(start);
+    String date(String(dayShortStr(start_dt.weekday + 1)) + ", " + String(start_dt.day) + ". " + String(monthNames[start_dt.month - 1]));
     int date_width = getTextWidth(date.c_str(), GOTHIC18, GOTHIC18_INFO);
     renderText((int)fminf(width - 5 - date_width, 257), 180, date.c_str(), GOTHIC18, GOTHIC18_INFO);
 
@@ -397,13 +429,13 @@ void Display::renderTodayOverview(const WeatherForecast &forecast, time_t start)
     int day_middle_y = 136;
 
     // Move up day temp if we have to show precipitation (keep 8px distance around middle)
-    if (roundf(forecast.precipitation * 10) >= 1) {
+    if (forecast.precipitation_sum >= 1) {
         paint->DrawBuffer(PRECIPITATION, PRECIPITATION_INFO, 312, 151, COLORED);
-        renderText(329, 148, String(String(forecast.precipitation, 1) + "mm").c_str(), CONSOLAS, CONSOLAS_INFO);
+        renderText(329, 148, String(String(forecast.precipitation(), 1) + "mm").c_str(), CONSOLAS, CONSOLAS_INFO);
         day_middle_y -= 13;
     }
-    int day_temp_max = ceilf(forecast.tempMax);
-    int day_temp_min = roundf(forecast.tempMin);
+    int day_temp_max = ceilf(forecast.tempMax());
+    int day_temp_min = roundf(forecast.tempMin());
 
     renderText(329, day_middle_y, String(String(day_temp_min) + "|" + String(day_temp_max)).c_str(), CONSOLAS, CONSOLAS_INFO);
 }
@@ -411,8 +443,10 @@ void Display::renderTodayOverview(const WeatherForecast &forecast, time_t start)
 void Display::renderCurrentWeather(const Weather &weather, int current_hour, int offset_hour)
 {
     int offset_3h = offset_hour / 3;
-    float current_temperature = weather.temperatures[offset_hour];
-    uint8_t current_icon = weather.icons[offset_3h];
+
+    // fall back to the current weather of the response once the series ran out
+    float current_temperature = weather.temperature_1h.has(offset_hour) ? weather.temperature(offset_hour) : weather.current.temperature();
+    uint8_t current_icon = weather.icons.has(offset_3h) ? weather.icons[offset_3h] : weather.current.icon;
 
     String hour_temp(current_temperature, 1);
 
@@ -428,28 +462,98 @@ void Display::renderCurrentWeather(const Weather &weather, int current_hour, int
     renderText(120 + (int)roundf((float)hour_temp_width / 2 - (float)hour_width / 2), 180, hour.c_str(), GOTHIC18, GOTHIC18_INFO);
 }
 
-void Display::renderWeather(Weather weather, int current_hour, int offset_hour)
+void Display::renderWeather(const Weather &weather, int current_hour, int offset_hour)
 {
     paint->DrawHorizontalLine(0, 72, width, COLORED);
     paint->DrawHorizontalLine(0, 200, width, COLORED);
 
-    render24hIcons(weather, NUM_3H, current_hour - current_hour % 3, offset_hour);
+    // old data (no update for a while) is shown from the current hour and day on
+    time_t rounded_time = weather.start + offset_hour * 3600;
+    int day = dayOffset(weather, rounded_time);
+
+    render24hIcons(weather, weather.icons.length, current_hour - current_hour % 3, offset_hour);
     renderCurrentWeather(weather, current_hour, offset_hour);
-    renderTodayOverview(weather.forecasts[0], weather.start);
-    renderWeatherForecast(weather.forecasts, NUM_FORECASTS);
+    renderTodayOverview(weather.forecasts[day], rounded_time);
+    renderWeatherForecast(weather.forecasts.values + day, weather.forecasts.length - day);
+
+    // hours of the first slot that have passed
+    int passed = offset_hour - slotOffset(offset_hour);
+    if (passed > 0) {
+        renderStale(0, 72, 11 + passed * 18, 93);
+    }
+}
 
-    if (offset_hour > 0) {
-        paint->InvertRectangle(0, 72, 11 + offset_hour * 18, 93, COLORED);
+// hours from the start of weather to the 3 hour slot of offset_hour
+int Display::slotOffset(int offset_hour)
+{
+    return offset_hour > 0 ? offset_hour - offset_hour % 3 : 0;
+}
+
+// forecast of the day of time, the last one if the forecasts ran out
+int Display::dayOffset(const Weather &weather, time_t time)
+{
+    int day = Civil::local(time).days - Civil::local(weather.forecasts.start).days;
+    if (day > weather.forecasts.length - 1) day = weather.forecasts.length - 1;
+    return day > 0 ? day : 0;
+}
+
+bool Display::covers(const Weather &weather, time_t current_time)
+{
+    time_t rounded_time = Civil::floorLocal(current_time + 1800, 3600); // nearest hour, as in setup()
+    int offset_hour = (rounded_time - weather.start) / 3600;
+    if (offset_hour < 0) {
+        return false;
+    }
+    time_t first = weather.start + slotOffset(offset_hour) * 3600;
+
+    // 10 minute steps of the precipitation chart, they end at the 1h series
+    time_t end_10min = first + horizon.hours_10min * 3600;
+    if (end_10min > weather.precipitation_1h.start) end_10min = weather.precipitation_1h.start;
+    if (weather.precipitation_10min.start + weather.precipitation_10min.length * STEP_10MIN < end_10min) {
+        return false;
+    }
+
+    // today and the days after it
+    return dayOffset(weather, rounded_time) + horizon.days <= weather.forecasts.length;
+}
+
+void Display::renderStale(int x0, int y0, int x1, int y1) {
+    if (paint_red == nullptr && DisplayPanel::bits_per_pixel == 1) {
+        paint->InvertRectangle(x0, y0, x1, y1, COLORED);
+        return;
+    }
+
+    // red (or light gray) background, keep black pixels visible on top
+    BasicPaint<DisplayPanel> *p = paint_red != nullptr ? paint_red : paint;
+    int background = paint_red != nullptr ? COLORED : LIGHT_GRAY;
+
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            if (!paint->CheckPixel(x, y, COLORED)) {
+                p->DrawAbsolutePixel(x, y, background);
+            }
+        }
     }
 }
 
 void Display::renderError(UpdateError error) {
+    // warnings go to the red plane if there is one
+    BasicPaint<DisplayPanel> *p = paint_red != nullptr ? paint_red : paint;
+
     if (error == UpdateError::ETime) {
-        paint->DrawBuffer(NOTIME, NOTIME_INFO, 5, 137 - 10, COLORED);
+        p->DrawBuffer(NOTIME, NOTIME_INFO, 5, 137 - 10, COLORED);
     } else if (error == UpdateError::EConnection) {
-        paint->DrawBuffer(NOCONNECTION, NOCONNECTION_INFO, 5, 137 - 10, COLORED);
+        p->DrawBuffer(NOCONNECTION, NOCONNECTION_INFO, 5, 137 - 10, COLORED);
     } else if (error == UpdateError::EWeather) {
-        paint->DrawBuffer(NOWEATHER, NOWEATHER_INFO, 5, 137 - 10, COLORED);
+        p->DrawBuffer(NOWEATHER, NOWEATHER_INFO, 5, 137 - 10, COLORED);
+    }
+}
+
+void Display::render(const RenderState &state) {
+    renderWeather(state.weather, state.current_hour, state.offset_hour);
+
+    if (state.error != UpdateError::ENone) {
+        renderError(state.error);
     }
 }
 
@@ -494,7 +598,7 @@ int Display::getLetterForFont(int letter, const unsigned char *font, const int *
 
 void Display::print()
 {
-    for (int i = 0; i < width * height / 8; i++) {
+    for (int i = 0; i < DisplayPanel::band_size; i++) {
         Serial.print((int)buffer[i]);
         Serial.print(" ");
         delay(1);
@@ -503,15 +607,231 @@ void Display::print()
     Serial.println("");
 }
 
+// full refresh of the frame in the buffer
 void Display::draw()
+{
+    uint8_t partial_count = 0;
+    RefreshPolicy policy(partial_count);
+    draw(policy);
+}
+
+// the buffer holds the whole frame, what the panel shows is not known: full refresh
+void Display::draw(RefreshPolicy &policy)
 {
     if (!initialized) {
         // Not initialized
         Serial.println("Nothing to draw"); 
         return;
     }
-    /* This displays the data from the SRAM in e-Paper module */
+
+    RefreshMode mode = policy.select(false, width * height, width * height);
+    Serial.println("Full refresh");
     epd.DisplayFrame(buffer);
+    policy.commit(mode);
+
+    /* Deep sleep */
+    epd.Sleep();
+
+    /* Reset initialized */
+    initialized = false;
+
+    Serial.println("Finished e-Paper");
+}
+
+void Display::draw(const RenderState &state, const RenderState &shown, RefreshPolicy &policy)
+{
+    // what is currently shown is rendered too, so only the difference has to be refreshed
+    if (shown.valid && DisplayPanel::partial_lut) {
+        drawChanges(state, shown, policy);
+        return;
+    }
+
+    if (DisplayPanel::num_bands > 1 || DisplayPanel::planes > 1) {
+        drawBands(state, policy);
+        return;
+    }
+
+    render(state);
+    draw(policy);
+}
+
+/*
+ * Shown and new frame are rendered in bands of half the height into the two halves of the
+ * frame buffer, there is no second frame buffer. Each band pair is compared and sent to the
+ * panel RAM (DTM1 shown, DTM2 new), the partial refresh then drives the changed window.
+ */
+void Display::drawChanges(const RenderState &state, const RenderState &shown, RefreshPolicy &policy)
+{
+    if (!initialized) {
+        // Not initialized
+        Serial.println("Nothing to draw"); 
+        return;
+    }
+
+    // only panels with a partial waveform get here, single band and single plane
+    const int rows = (height + 1) / 2;
+    const int stride = DisplayPanel::stride;
+    unsigned char *band_shown = buffer;
+    unsigned char *band_new = buffer + rows * stride;
+    BasicPaint<DisplayPanel> paint_shown(band_shown, width, rows);
+    BasicPaint<DisplayPanel> paint_new(band_new, width, rows);
+    BasicPaint<DisplayPanel> *frame_paint = paint;
+
+    // count changed pixels and find the bounding box (in bytes horizontally)
+    unsigned int changed = 0;
+    int x0 = stride, x1 = -1, y0 = height, y1 = -1;
+
+    for (int y = 0; y < height; y += rows) {
+        int l = height - y < rows ? height - y : rows;
+
+        paint = &paint_shown;
+        paint->SetOffsetY(y);
+        paint->Clear(UNCOLORED);
+        render(shown);
+
+        paint = &paint_new;
+        paint->SetOffsetY(y);
+        paint->Clear(UNCOLORED);
+        render(state);
+
+        for (int row = 0; row < l; row++) {
+            for (int x = 0; x < stride; x++) {
+                unsigned char diff = band_shown[row * stride + x] ^ band_new[row * stride + x];
+                if (diff == 0) continue;
+
+                changed += __builtin_popcount(diff);
+                if (x < x0) x0 = x;
+                if (x > x1) x1 = x;
+                if (y + row < y0) y0 = y + row;
+                y1 = y + row;
+            }
+        }
+
+        epd.SetPartialWindowPrevious(band_shown, 0, y, width, l);
+        epd.SetPartialWindow(band_new, 0, y, width, l);
+    }
+    paint = frame_paint;
+
+    RefreshMode mode = policy.select(true, changed, width * height);
+
+    if (mode == RefreshMode::RFull) {
+        // the full waveform starts from white (DTM1), the whole frame is rendered once more
+        Serial.println("Full refresh");
+        paint->SetOffsetY(0);
+        paint->Clear(UNCOLORED);
+        render(state);
+        epd.DisplayFrame(buffer);
+    } else if (mode == RefreshMode::RPartial) {
+        Serial.print("Partial refresh, changed pixels: ");
+        Serial.println(changed);
+        epd.DisplayFramePartial(NULL, NULL, x0 * 8, y0, (x1 - x0 + 1) * 8, y1 - y0 + 1);
+    } else {
+        Serial.println("Nothing changed, no refresh");
+    }
+
+    policy.commit(mode);
+
+    /* Deep sleep */
+    epd.Sleep();
+
+    /* Reset initialized */
+    initialized = false;
+
+    Serial.println("Finished e-Paper");
+}
+
+void Display::drawBands(const RenderState &state, RefreshPolicy &policy)
+{
+    if (!initialized) {
+        // Not initialized
+        Serial.println("Nothing to draw"); 
+        return;
+    }
+
+    RefreshMode mode = policy.select(false, width * height, width * height);
+    Serial.println("Full refresh");
+
+    // render the whole layout once per band, only the band is kept in RAM
+    for (int y = 0; y < height; y += DisplayPanel::band_height) {
+        paint->SetOffsetY(y);
+        paint->Clear(UNCOLORED);
+        if (paint_red != nullptr) {
+            paint_red->SetOffsetY(y);
+            paint_red->Clear(UNCOLORED);
+        }
+
+        render(state);
+
+        if (paint_red != nullptr) {
+            epd.SetPartialWindowBlack(buffer, 0, y, width, DisplayPanel::band_height);
+            epd.SetPartialWindowRed(buffer_red, 0, y, width, DisplayPanel::band_height);
+        } else {
+            epd.SetPartialWindow(buffer, 0, y, width, DisplayPanel::band_height);
+        }
+    }
+
+    epd.DisplayFrame();
+    policy.commit(mode);
+
+    /* Deep sleep */
+    epd.Sleep();
+
+    /* Reset initialized */
+    initialized = false;
+
+    Serial.println("Finished e-Paper");
+}
+
+void Display::sendBand(void *display, const uint8_t *band, int index)
+{
+    Display *self = static_cast<Display *>(display);
+    self->epd.SetPartialWindow(band, 0, index * DisplayPanel::band_height, width, DisplayPanel::band_height);
+}
+
+// show a frame rendered by the server (see frame.h), decoded band by band straight into the panel
+bool Display::drawFrame(Client &client)
+{
+    if (!initialized) {
+        // Not initialized
+        Serial.println("Nothing to draw"); 
+        return false;
+    }
+
+    if (DisplayPanel::bits_per_pixel != 1 || DisplayPanel::planes != 1) {
+        Serial.println("Frames are 1 bit black / white only");
+        return false;
+    }
+
+    FrameDecoder decoder(buffer, DisplayPanel::band_size, sendBand, this);
+    uint8_t chunk[64];
+    unsigned long last = millis();
+
+    while (!decoder.done() && !decoder.error) {
+        int available = client.available();
+        if (available <= 0) {
+            if (!client.connected() || millis() - last > FRAME_TIMEOUT) break;
+            delay(1);
+            continue;
+        }
+
+        int read = client.read(chunk, available < (int)sizeof(chunk) ? available : sizeof(chunk));
+        for (int i = 0; i < read; i++) {
+            decoder.feed(chunk[i]);
+        }
+        if (read > 0) {
+            last = millis();
+        }
+    }
+
+    if (!decoder.done() || decoder.width != width || decoder.height != height) {
+        // the data RAM is rewritten by the next refresh, the panel keeps what it shows
+        Serial.println("Broken frame, no refresh");
+        epd.Sleep();
+        initialized = false;
+        return false;
+    }
+
+    epd.DisplayFrame();
 
     /* Deep sleep */
     epd.Sleep();
@@ -520,6 +840,7 @@ void Display::draw()
     initialized = false;
 
     Serial.println("Finished e-Paper");
+    return true;
 }
 
 Display::~Display() {
@@ -529,5 +850,7 @@ Display::~Display() {
     }
 
     delete[] buffer;
+    delete[] buffer_red;
     delete paint;
+    delete paint_red;
 }
\ No newline at end of file
@@ -0,0 +1,111 @@
+#include <string.h>
+
+#include "frame.h"
+
+void FrameDecoder::write(uint8_t value, int count) {
+  while (count > 0) {
+    int n = band_size - filled < count ? band_size - filled : count;
+    memset(band + filled, value, n);
+    filled += n;
+    count -= n;
+
+    if (filled == band_size) {
+      callback(context, band, index++);
+      filled = 0;
+    }
+  }
+}
+
+bool FrameDecoder::feed(uint8_t c) {
+  if (error) {
+    return false;
+  }
+
+  if (header_length < FRAME_HEADER_SIZE) {
+    header[header_length++] = c;
+    if (header_length < FRAME_HEADER_SIZE) {
+      return true;
+    }
+
+    width = header[4] | header[5] << 8;
+    height = header[6] | header[7] << 8;
+    size = (long)(width / 8) * height;
+    if (memcmp(header, "WXF", 3) != 0 || header[3] != FRAME_VERSION || width % 8 != 0 || size % band_size != 0) {
+      error = true;
+    }
+    return !error;
+  }
+
+  if (literal > 0) {
+    literal--;
+  } else if (repeat > 0) {
+    if (repeat > size) {
+      error = true;
+      return false;
+    }
+    size -= repeat;
+    write(c, repeat);
+    repeat = 0;
+    return true;
+  } else {
+    if (c < 128) {
+      literal = c + 1;
+    } else if (c > 128) {
+      repeat = 257 - c;
+    }
+    return true;
+  }
+
+  if (size == 0) {
+    error = true;
+    return false;
+  }
+  size--;
+  write(c, 1);
+  return true;
+}
+
+bool FrameDecoder::done() {
+  return !error && header_length == FRAME_HEADER_SIZE && size == 0 && literal == 0 && repeat == 0;
+}
+
+size_t encodeFrame(const uint8_t *plane, int width, int height, uint8_t *out, size_t capacity) {
+  size_t size = (size_t)(width / 8) * height;
+  size_t length = FRAME_HEADER_SIZE;
+  if (capacity < length) return 0;
+
+  memcpy(out, "WXF", 3);
+  out[3] = FRAME_VERSION;
+  out[4] = width & 0xff;
+  out[5] = width >> 8;
+  out[6] = height & 0xff;
+  out[7] = height >> 8;
+
+  size_t i = 0;
+  while (i < size) {
+    // run of equal bytes
+    size_t run = 1;
+    while (i + run < size && run < 128 && plane[i + run] == plane[i]) run++;
+
+    if (run >= 2) {
+      if (length + 2 > capacity) return 0;
+      out[length++] = (uint8_t)(257 - run);
+      out[length++] = plane[i];
+      i += run;
+      continue;
+    }
+
+    // literal up to the next run of 3 (a run of 2 is not worth breaking it)
+    size_t start = i;
+    while (i < size && i - start < 128) {
+      if (i + 2 < size && plane[i] == plane[i + 1] && plane[i] == plane[i + 2]) break;
+      i++;
+    }
+    size_t n = i - start;
+    if (length + 1 + n > capacity) return 0;
+    out[length++] = (uint8_t)(n - 1);
+    memcpy(out + length, plane + start, n);
+    length += n;
+  }
+  return length;
+}
@@ -0,0 +1,310 @@
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "http.h"
+
+// states of HttpBody, the chunk ones follow "size[;extension]\r\n data \r\n ... 0\r\n trailer \r\n"
+#define BODY_DATA 0
+#define BODY_SIZE 1
+#define BODY_EXTENSION 2
+#define BODY_DATA_END 3
+#define BODY_TRAILER 4
+#define BODY_TRAILER_LINE 5
+#define BODY_DONE 6
+
+void HttpRequest::append(const char *str, size_t n) {
+  if (length + n > sizeof(buffer)) {
+    overflow = true;
+    return;
+  }
+  memcpy(buffer + length, str, n);
+  length += n;
+}
+
+void HttpRequest::begin(const char *lines, const char *host) {
+  length = 0;
+  overflow = false;
+
+  bool has_host = false;
+  const char *line = lines;
+  while (*line) {
+    const char *end = strchr(line, '\n');
+    size_t n = end ? end - line : strlen(line);
+    if (n > 0 && line[n - 1] == '\r') n--;
+
+    if (n >= 5 && strncasecmp(line, "Host:", 5) == 0) has_host = true;
+    append(line, n);
+    append("\r\n", 2);
+
+    if (!end) break;
+    line = end + 1;
+  }
+
+  if (!has_host) {
+    header("Host", host);
+  }
+}
+
+void HttpRequest::header(const char *name, const char *value) {
+  append(name, strlen(name));
+  append(": ", 2);
+  append(value, strlen(value));
+  append("\r\n", 2);
+}
+
+void HttpRequest::conditional(const HttpValidators &validators) {
+  if (validators.etag[0]) header("If-None-Match", validators.etag);
+  if (validators.last_modified[0]) header("If-Modified-Since", validators.last_modified);
+}
+
+bool HttpRequest::send(Client &client) {
+  append("\r\n", 2);
+  if (overflow) {
+    return false;
+  }
+  return client.write(reinterpret_cast<const uint8_t *>(buffer), length) == length;
+}
+
+// one line without \r\n into line (cut at size - 1), returns the full length, -1 on timeout or closed connection
+static int readLine(Client &client, char *line, size_t size, unsigned long start, unsigned long timeout) {
+  size_t n = 0;
+  size_t length = 0;
+  int last = -1;
+
+  while (true) {
+    int c = client.read();
+    if (c < 0) {
+      if (!client.connected() || millis() - start >= timeout) return -1;
+      delay(1);
+      continue;
+    }
+    if (c == '\n') break;
+    if (n < size - 1) line[n++] = c;
+    length++;
+    last = c;
+  }
+
+  if (last == '\r') {
+    length--;
+    if (n > length) n = length;
+  }
+  line[n] = '\0';
+  return length;
+}
+
+// keep a validator only if it is complete
+static void copyValidator(char *validator, const char *value, bool cut) {
+  size_t length = strlen(value);
+  if (cut || length >= HTTP_VALIDATOR_SIZE) {
+    validator[0] = '\0';
+    return;
+  }
+  memcpy(validator, value, length + 1);
+}
+
+bool readResponseHead(Client &client, HttpResponse &response, unsigned long timeout) {
+  char line[HTTP_LINE_SIZE];
+  unsigned long start = millis();
+
+  do {
+    // "HTTP/1.1 200 OK", 1xx responses are followed by the real one
+    if (readLine(client, line, sizeof(line), start, timeout) < 0) return false;
+    if (strncmp(line, "HTTP/1.", 7) != 0 || line[8] != ' ') return false;
+    response.status = atoi(line + 9);
+    if (response.status < 100 || response.status > 999) return false;
+
+    response.framing = HUntilClose;
+    response.content_length = -1;
+    response.encoding = HIdentity;
+    response.validators.etag[0] = '\0';
+    response.validators.last_modified[0] = '\0';
+
+    while (true) {
+      int n = readLine(client, line, sizeof(line), start, timeout);
+      if (n < 0) return false;
+      if (n == 0) break;
+
+      char *value = strchr(line, ':');
+      if (!value) continue;
+      *value++ = '\0';
+      while (*value == ' ' || *value == '\t') value++;
+
+      if (strcasecmp(line, "Content-Length") == 0) {
+        response.content_length = strtol(value, nullptr, 10);
+        if (response.framing != HChunked) response.framing = HLength;
+      } else if (strcasecmp(line, "Transfer-Encoding") == 0) {
+        // chunked is always the last coding and wins over Content-Length
+        size_t length = strlen(value);
+        if (length >= 7 && strcasecmp(value + length - 7, "chunked") == 0) response.framing = HChunked;
+      } else if (strcasecmp(line, "Content-Encoding") == 0) {
+        if (strcasecmp(value, "gzip") == 0 || strcasecmp(value, "x-gzip") == 0) {
+          response.encoding = HGzip;
+        } else if (strcasecmp(value, "deflate") == 0) {
+          response.encoding = HDeflate;
+        } else if (strcasecmp(value, "identity") != 0) {
+          response.encoding = HUnsupported;
+        }
+      } else if (strcasecmp(line, "ETag") == 0) {
+        copyValidator(response.validators.etag, value, n >= HTTP_LINE_SIZE);
+      } else if (strcasecmp(line, "Last-Modified") == 0) {
+        copyValidator(response.validators.last_modified, value, n >= HTTP_LINE_SIZE);
+      }
+    }
+  } while (response.status < 200);
+
+  // no body, whatever the headers say
+  if (response.status == 204 || response.status == 304) {
+    response.framing = HLength;
+    response.content_length = 0;
+  }
+  return response.framing != HLength || response.content_length >= 0;
+}
+
+void HttpBody::begin(Client &client, const HttpResponse &response) {
+  this->client = &client;
+  framing = response.framing;
+  error = false;
+
+  switch (framing) {
+    case HLength:
+      remaining = response.content_length;
+      state = remaining > 0 ? BODY_DATA : BODY_DONE;
+      break;
+    case HChunked:
+      remaining = 0;
+      digits = 0;
+      state = BODY_SIZE;
+      break;
+    default:
+      remaining = 0;
+      state = BODY_DATA;
+  }
+}
+
+// consume chunk framing as far as it has arrived, true if body data is next
+bool HttpBody::advance() {
+  while (!error && state != BODY_DATA && state != BODY_DONE) {
+    if (client->available() <= 0) {
+      return false;
+    }
+    int c = client->read();
+    if (c < 0) {
+      return false;
+    }
+
+    switch (state) {
+      case BODY_SIZE:
+        if (isxdigit(c)) {
+          if (remaining > 0x7ffffff) {
+            error = true;
+            break;
+          }
+          remaining = remaining * 16 + (isdigit(c) ? c - '0' : (c | 0x20) - 'a' + 10);
+          digits++;
+          break;
+        }
+        if (c == '\r') break;
+        if (c != '\n') {
+          state = BODY_EXTENSION;
+          break;
+        }
+        // fall through: end of the size line
+      case BODY_EXTENSION:
+        if (c != '\n') break;
+        if (digits == 0) {
+          error = true;
+        } else {
+          state = remaining > 0 ? BODY_DATA : BODY_TRAILER;
+        }
+        break;
+      case BODY_DATA_END:
+        if (c == '\r') break;
+        if (c != '\n') {
+          error = true;
+          break;
+        }
+        remaining = 0;
+        digits = 0;
+        state = BODY_SIZE;
+        break;
+      case BODY_TRAILER:
+        if (c == '\r') break;
+        state = c == '\n' ? BODY_DONE : BODY_TRAILER_LINE;
+        break;
+      case BODY_TRAILER_LINE:
+        if (c == '\n') state = BODY_TRAILER;
+        break;
+    }
+  }
+  return !error && state == BODY_DATA;
+}
+
+// body data was read, the chunk or body may be complete
+void HttpBody::consumed(int n) {
+  if (n <= 0 || framing == HUntilClose) {
+    return;
+  }
+  remaining -= n;
+  if (remaining == 0) {
+    state = framing == HChunked ? BODY_DATA_END : BODY_DONE;
+  }
+}
+
+bool HttpBody::done() {
+  if (error) {
+    return false;
+  }
+  if (framing == HUntilClose) {
+    return !client->connected();
+  }
+  advance();
+  return state == BODY_DONE;
+}
+
+int HttpBody::available() {
+  if (!advance()) {
+    return 0;
+  }
+  int available = client->available();
+  if (framing != HUntilClose && available > remaining) {
+    available = remaining;
+  }
+  return available;
+}
+
+int HttpBody::read() {
+  if (!advance()) {
+    return -1;
+  }
+  int c = client->read();
+  consumed(c < 0 ? 0 : 1);
+  return c;
+}
+
+int HttpBody::read(uint8_t *buf, size_t size) {
+  if (!advance()) {
+    return -1;
+  }
+  if (framing != HUntilClose && (long)size > remaining) {
+    size = remaining;
+  }
+  int n = client->read(buf, size);
+  consumed(n);
+  return n;
+}
+
+int HttpBody::peek() {
+  if (!advance()) {
+    return -1;
+  }
+  return client->peek();
+}
+
+uint8_t HttpBody::connected() {
+  if (!client || error || state == BODY_DONE) {
+    return 0;
+  }
+  return client->connected();
+}
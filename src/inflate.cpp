@@ -0,0 +1,209 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "inflate.h"
+
+#define DEFLATE_WINDOW_SIZE 32768 // largest distance of a back reference
+
+// header states, gzip: id1 id2 cm flg mtime:4 xfl os [xlen:2 extra] [name\0] [comment\0] [crc:2]
+#define HEADER_FIXED 0
+#define HEADER_XLEN 1
+#define HEADER_EXTRA 2
+#define HEADER_NAME 3
+#define HEADER_COMMENT 4
+#define HEADER_CRC 5
+#define HEADER_DONE 6
+
+#define GZIP_FHCRC 0x02
+#define GZIP_FEXTRA 0x04
+#define GZIP_FNAME 0x08
+#define GZIP_FCOMMENT 0x10
+
+bool InflateStream::begin(Client &client, InflateFormat format) {
+  end();
+
+  decompressor = (tinfl_decompressor *)malloc(sizeof(tinfl_decompressor));
+  window = (uint8_t *)malloc(INFLATE_WINDOW_SIZE);
+  if (!decompressor || !window) {
+    end();
+    return false;
+  }
+  tinfl_init(decompressor);
+
+  this->client = &client;
+  this->format = format;
+  input_position = 0;
+  input_length = 0;
+  window_position = 0;
+  output_position = 0;
+  pending = 0;
+  total = 0;
+  window_fits = INFLATE_WINDOW_SIZE >= DEFLATE_WINDOW_SIZE;
+  header_state = HEADER_FIXED;
+  header_flags = 0;
+  header_count = 0;
+  extra_length = 0;
+  finished = false;
+  error = false;
+  return true;
+}
+
+void InflateStream::end() {
+  free(decompressor);
+  free(window);
+  decompressor = nullptr;
+  window = nullptr;
+}
+
+// move on to the next gzip field that is present
+void InflateStream::nextField() {
+  header_count = 0;
+  while (++header_state < HEADER_DONE) {
+    if (header_state == HEADER_XLEN && header_flags & GZIP_FEXTRA) return;
+    if (header_state == HEADER_EXTRA && extra_length > 0) return;
+    if (header_state == HEADER_NAME && header_flags & GZIP_FNAME) return;
+    if (header_state == HEADER_COMMENT && header_flags & GZIP_FCOMMENT) return;
+    if (header_state == HEADER_CRC && header_flags & GZIP_FHCRC) return;
+  }
+}
+
+// one byte of the gzip or zlib header, false if it is not one
+bool InflateStream::header(uint8_t c) {
+  if (format == IZlib) {
+    // cmf flg: deflate, window 2^(cinfo + 8), no preset dictionary
+    if (header_count++ == 0) {
+      header_flags = c;
+      return (c & 0x0f) == 8 && (c >> 4) <= 7;
+    }
+    if ((header_flags * 256 + c) % 31 != 0 || c & 0x20) return false;
+    if (1L << ((header_flags >> 4) + 8) <= INFLATE_WINDOW_SIZE) window_fits = true;
+    header_state = HEADER_DONE;
+    return true;
+  }
+
+  switch (header_state) {
+    case HEADER_FIXED:
+      if ((header_count == 0 && c != 0x1f) || (header_count == 1 && c != 0x8b) || (header_count == 2 && c != 8)) return false;
+      if (header_count == 3) header_flags = c;
+      if (++header_count == 10) nextField();
+      break;
+    case HEADER_XLEN:
+      // little endian
+      if (header_count++ == 0) {
+        extra_length = c;
+      } else {
+        extra_length |= c << 8;
+        nextField();
+      }
+      break;
+    case HEADER_EXTRA:
+      if (--extra_length == 0) nextField();
+      break;
+    case HEADER_NAME:
+    case HEADER_COMMENT:
+      if (c == 0) nextField();
+      break;
+    case HEADER_CRC:
+      if (++header_count == 2) nextField();
+      break;
+  }
+  return true;
+}
+
+// inflate the next piece into the window if everything before was handed out, true if bytes are pending
+bool InflateStream::pump() {
+  while (pending == 0 && !finished && !error) {
+    if (input_position == input_length) {
+      if (client->available() <= 0) {
+        return false;
+      }
+      int n = client->read(input, sizeof(input));
+      if (n <= 0) {
+        return false;
+      }
+      input_position = 0;
+      input_length = n;
+    }
+
+    while (header_state != HEADER_DONE && input_position < input_length) {
+      if (!header(input[input_position++])) {
+        Serial.println(F("Inflate: bad header"));
+        error = true;
+        return false;
+      }
+    }
+    if (header_state != HEADER_DONE) {
+      continue;
+    }
+
+    // with a small window only the first INFLATE_WINDOW_SIZE bytes are known to be right
+    size_t out_size = INFLATE_WINDOW_SIZE - window_position;
+    if (!window_fits && out_size > INFLATE_WINDOW_SIZE - total) {
+      out_size = INFLATE_WINDOW_SIZE - total;
+      if (out_size == 0) {
+        Serial.println(F("Inflate: response larger than INFLATE_WINDOW_SIZE"));
+        error = true;
+        return false;
+      }
+    }
+
+    size_t in_size = input_length - input_position;
+    tinfl_status status = tinfl_decompress(decompressor, input + input_position, &in_size,
+      window, window + window_position, &out_size, TINFL_FLAG_HAS_MORE_INPUT);
+    input_position += in_size;
+
+    output_position = window_position;
+    pending = out_size;
+    window_position = (window_position + out_size) & (INFLATE_WINDOW_SIZE - 1);
+    total += out_size;
+
+    if (status < TINFL_STATUS_DONE) {
+      Serial.println(F("Inflate: broken stream"));
+      error = true;
+    } else if (status == TINFL_STATUS_DONE) {
+      // the gzip / adler trailer is not checked, the parser notices broken content
+      finished = true;
+    }
+  }
+  return pending > 0;
+}
+
+int InflateStream::available() {
+  return pump() ? pending : 0;
+}
+
+int InflateStream::read() {
+  if (!pump()) {
+    return -1;
+  }
+  pending--;
+  return window[output_position++];
+}
+
+int InflateStream::read(uint8_t *buf, size_t size) {
+  if (!pump()) {
+    return -1;
+  }
+  size_t n = pending < size ? pending : size;
+  memcpy(buf, window + output_position, n);
+  output_position += n;
+  pending -= n;
+  return n;
+}
+
+int InflateStream::peek() {
+  if (!pump()) {
+    return -1;
+  }
+  return window[output_position];
+}
+
+uint8_t InflateStream::connected() {
+  if (!client || error) {
+    return 0;
+  }
+  if (pending > 0) {
+    return 1;
+  }
+  return !finished && client->connected();
+}
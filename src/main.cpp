@@ -1,18 +1,92 @@
 #include "weather.h"
+#include "civiltime.h"
+#include "weatherparser.h"
 #include "display.h"
+#include "frame.h"
 #include "webrequest.h"
 #include "wifi_login.h"
 
+#include <lwip/apps/sntp.h>
+
 #define uS_TO_S_FACTOR 1000000  /* Conversion factor for micro seconds to seconds */
 
-#define MAX_TIME_SYNC 60
+#define MAX_TIME_SYNC 60 // s to wait for SNTP without a clock
+#define TIME_SYNC_RTC 5 // s to wait for SNTP when the clock ran through deep sleep
+#define TIME_SYNC_POLL 10 // ms
 #define UPDATE_FREQUENCY 3 * 3600
+#define NOT_MODIFIED_HOURS 9 // weather is kept this far beyond the layout, the server may answer 304 meanwhile
 
 RTC_DATA_ATTR Weather weather_save = {0};
+RTC_DATA_ATTR HttpValidators validators = {0}; // of the response weather_save came from
+RTC_DATA_ATTR sslclient_session tls_session = {0}; // resumed on the next wake instead of a full handshake
+RTC_DATA_ATTR WiFiCache wifi_cache = {0}; // access point and lease of the last connect
 RTC_DATA_ATTR char tz[33] = {0};
+RTC_DATA_ATTR RenderState shown = {0}; // what is currently on the panel
+RTC_DATA_ATTR uint8_t partial_count = 0;
+
+#if USE_WIRE_FORMAT && USE_WEATHER_API
+bool requestWeather(WebRequest &web, Weather *weather, const Horizon &horizon, time_t current_time) {
+  // a few hundred bytes from resources/weather_proxy.py instead of the JSON response
+  uint8_t data[WIRE_MAX_SIZE];
+  Weather decoded = {0};
+
+  if (!web.requestWeather()) {
+    return false;
+  }
+  int length = web.readBody(data, sizeof(data));
+  web.printStatistics();
+  if (length <= 0 || !WeatherAPI::decodeWeather(data, length, &decoded, horizon, current_time)) {
+    Serial.println(F("Decoding weather failed"));
+    return false;
+  }
+
+  Serial.print(F("Weather received, bytes: "));
+  Serial.println(length);
+
+  *weather = decoded;
+  return true;
+}
+#elif USE_STREAM_PARSER
+bool requestWeather(WebRequest &web, Weather *weather, const Horizon &horizon, time_t current_time) {
+  // parse into a fresh struct, weather keeps the old data if the response is broken
+  Weather parsed = {0};
+
+#if USE_WEATHER_API
+  if (!web.requestWeather()) {
+    return false;
+  }
+  WeatherParser parser(&parsed, horizon, current_time);
+  bool success = parser.parse(web.content());
+  web.printStatistics();
+#else
+  // take the time from the sample so old data will be used
+  WeatherParser parser(&parsed, horizon, 0);
+  bool success = parser.parse(json);
+#endif
 
-bool requestWeather(WebRequest &web, Weather *weather, time_t current_time) {
+  if (!success) {
+    Serial.print(F("Parsing weather failed: "));
+    Serial.println(parser.errorString());
+    return false;
+  }
+
+#if !USE_WEATHER_API
+  // Set start times to rounded current time to make up for old data set
+  time_t rounded_time = Civil::floorLocal(current_time, STEP_3H); // round down to three hours
+
+  parsed.rebase(rounded_time);
+  parsed.current.time = rounded_time;
+#endif
+
+  *weather = parsed;
+  return true;
+}
+#else
+bool requestWeather(WebRequest &web, Weather *weather, const Horizon &horizon, time_t current_time) {
   DynamicJsonDocument doc(JSON_CAPACITY);
+
+  StaticJsonDocument<JSON_FILTER_CAPACITY> filter;
+  WeatherAPI::buildFilter(filter);
   
 #if USE_WEATHER_API
   bool success = web.requestWeather();
@@ -20,9 +94,10 @@ bool requestWeather(WebRequest &web, Weather *weather, time_t current_time) {
     return false;
   }
   // Deserialize the JSON document
-  DeserializationError error = deserializeJson(doc, web.client);
+  DeserializationError error = deserializeJson(doc, web.content(), DeserializationOption::Filter(filter));
+  web.printStatistics();
 #else
-  DeserializationError error = deserializeJson(doc, json);
+  DeserializationError error = deserializeJson(doc, json, DeserializationOption::Filter(filter));
   
   // Set local time so old data will be used
   time_t prev_time = current_time;
@@ -35,25 +110,25 @@ bool requestWeather(WebRequest &web, Weather *weather, time_t current_time) {
     return false;
   }
 
+  // peak usage to check JSON_CAPACITY against real responses
+  Serial.print(F("JSON memory usage: "));
+  Serial.println((int)doc.memoryUsage());
+
   // serializeJson(doc, Serial);
 
-  bool success2 = WeatherAPI::parseWeather(doc, weather, current_time);
+  bool success2 = WeatherAPI::parseWeather(doc, weather, horizon, current_time);
   
   #if !USE_WEATHER_API
   // Set start times to rounded current time to make up for old data set
-  struct tm rounded = *localtime(&prev_time);
-  rounded.tm_sec = 0;
-  rounded.tm_min = 0;
-  rounded.tm_hour -= rounded.tm_hour % 3; // round down to three hours
-  time_t rounded_time = mktime(&rounded);
-
-  weather->start = rounded_time;
-  weather->start_low = rounded_time;
+  time_t rounded_time = Civil::floorLocal(prev_time, STEP_3H); // round down to three hours
+
+  weather->rebase(rounded_time);
   weather->current.time = rounded_time;
   #endif
 
   return success2;
 }
+#endif
 
 bool tryUpdateTime(WebRequest *web, time_t &current_time) {
   web->connect();
@@ -62,39 +137,94 @@ bool tryUpdateTime(WebRequest *web, time_t &current_time) {
 
   struct tm info;
 
-  // Give it up to MAX_TIME_SYNC seconds to synchronize
-  if(!getLocalTime(&info, MAX_TIME_SYNC * 1000)){
+  // the clock keeps running in deep sleep, then SNTP only corrects it and gets a short deadline
+  bool clock_set = getLocalTime(&info, 0);
+  unsigned long timeout = (clock_set ? TIME_SYNC_RTC : MAX_TIME_SYNC) * 1000UL;
+
+  // IDF 3.x has no sync callback, lwIP marks the server reachable once its answer set the clock
+  unsigned long start = millis();
+  while (!sntp_getreachability(0)) {
+    if (millis() - start >= timeout) break;
+    delay(TIME_SYNC_POLL);
+  }
+
+  if (sntp_getreachability(0)) {
+    Serial.print("Time synchronized in ");
+    Serial.print(millis() - start);
+    Serial.println(" ms");
+  } else if (clock_set) {
+    Serial.println("No time sync, keeping the RTC clock");
+  } else {
     Serial.println("Failed to get time");
     return false;
   }
 
   // copy TZ environment variable to RTC RAM
   strcpy(tz, getenv("TZ"));
+  Civil::setZone(tz);
   
   current_time = time(NULL);
   
   return true;
 }
 
+void sleepUntilNextHour() {
+  // wake up every hour (at :05)
+  uint64_t time_to_sleep = 300 + 3600 - time(NULL) % 3600;
+
+  esp_sleep_enable_timer_wakeup(time_to_sleep * uS_TO_S_FACTOR);
+  esp_deep_sleep_start();
+}
+
+#if USE_THIN_CLIENT && USE_WEATHER_API
+void setup() {
+  Serial.begin(9600);
+
+  WebRequest web = WebRequest();
+  web.client.setSession(&tls_session);
+  web.wifi_cache = &wifi_cache;
+  Display *display = new Display();
+
+  // nothing here needs the time, but the wake up at :05 does, the RTC drifts in deep sleep
+  time_t current_time = 0;
+  if (!web.connect() || !tryUpdateTime(&web, current_time)) {
+    Serial.println(F("No time sync, waking up by the RTC clock"));
+  }
+
+  // the server parses and renders (weather_proxy.py --renderer), the frame goes straight to the panel
+  if (!web.requestWeather()) {
+    Serial.println(F("No frame, keeping the panel"));
+  } else if (display->initialize(false)) {
+    display->drawFrame(web.content());
+    web.printStatistics();
+  }
+  delete display;
+  web.disconnect();
+
+  // the panel content is not known to the render path any more
+  shown.valid = false;
+
+  sleepUntilNextHour();
+}
+#else
 void setup() {
   //Initialize serial and wait for port to open:
   Serial.begin(9600);
   
   WebRequest web = WebRequest();
+  web.client.setSession(&tls_session);
+  web.wifi_cache = &wifi_cache;
   Display *display = new Display();
   Weather weather = weather_save;
 
-  if (strlen(tz) > 0) {
-    // if set load TZ environment variable from RTC RAM
-    setenv("TZ", tz, 1);
-    tzset();
-  }
+  // time zone rules from RTC RAM, parsed once per wake (UTC until the first time sync)
+  Civil::setZone(tz);
 
   // check if we should update
   time_t current_time = time(NULL); // wrong date will be much higher than last_update = 0 as well
-  struct tm current = *localtime(&current_time);
+  Civil::DateTime current = Civil::local(current_time);
 
-  int rounded_hour = current.tm_hour + (int)roundf((float)current.tm_min / 60);
+  int rounded_hour = current.hour + (int)roundf((float)current.minute / 60);
 
   UpdateError error = UpdateError::ENone;
   if (current_time == 0 || rounded_hour % 3 == 0) {
@@ -102,39 +232,48 @@ void setup() {
       error = UpdateError::EConnection;
     } else if(!tryUpdateTime(&web, current_time)) {
       error = UpdateError::ETime;
-    } else if(!requestWeather(web, &weather, current_time)) {
-      error = UpdateError::EWeather;
     } else {
-      weather_save = weather;
+      // parsed further ahead than the layout shows, so weather_save still covers it after a few 304
+      Horizon horizon = {
+        (uint8_t)(Display::horizon.hours + NOT_MODIFIED_HOURS),
+        (uint8_t)(Display::horizon.hours_10min + NOT_MODIFIED_HOURS),
+        (uint8_t)(Display::horizon.days + 1)
+      };
+      // a 304 keeps weather_save, only ask for it while that still fills the layout
+      if (current_time - (time_t)weather_save.start <= NOT_MODIFIED_HOURS * 3600 && Display::covers(weather_save, current_time)) {
+        web.conditional = &validators;
+      }
+
+      if (!requestWeather(web, &weather, horizon, current_time)) {
+        // on 304 the saved weather is shown, no error
+        if (!web.notModified()) error = UpdateError::EWeather;
+      } else {
+        weather_save = weather;
+        validators = web.response.validators;
+      }
     }
   }
 
-  current = *localtime(&current_time);
+  current = Civil::local(current_time);
 
-  display->initialize(true);
+  // every refresh rewrites the data RAM it uses, clearing is only needed while the panel content is unknown
+  display->initialize(!shown.valid);
 
-  rounded_hour = current.tm_hour + (int)roundf((float)current.tm_min / 60);
-  current.tm_hour = rounded_hour;
-  current.tm_min = 0;
-  current.tm_sec = 0;
-  time_t rounded_time = mktime(&current);
+  rounded_hour = current.hour + (int)roundf((float)current.minute / 60);
+  time_t rounded_time = Civil::floorLocal(current_time + 1800, 3600); // nearest hour
   int offset_hour = (rounded_time - weather.start) / 3600;
 
-  display->renderWeather(weather, rounded_hour, offset_hour);
-
-  if (error != UpdateError::ENone) {
-    display->renderError(error);
-  }
+  RenderState state = {.valid = true, .current_hour = rounded_hour, .offset_hour = offset_hour, .error = error, .weather = weather};
 
-  display->draw();
+  RefreshPolicy policy(partial_count);
+  display->draw(state, shown, policy);
   delete display;
 
-  // wake up every hour (at :05)
-  uint64_t time_to_sleep = 300 + 3600 - time(NULL) % 3600;
+  shown = state;
 
-  esp_sleep_enable_timer_wakeup(time_to_sleep * uS_TO_S_FACTOR);
-  esp_deep_sleep_start();
+  sleepUntilNextHour();
 }
+#endif
 
 void loop() {
 
@@ -0,0 +1,30 @@
+#include "refresh.h"
+
+RefreshMode RefreshPolicy::select(bool has_previous, unsigned int changed_pixels, unsigned int total_pixels) {
+    // panel content unknown (first boot, error while rendering)
+    if (!has_previous) {
+        return RefreshMode::RFull;
+    }
+
+    if (changed_pixels == 0) {
+        return RefreshMode::RNone;
+    }
+
+    if (partial_count >= FULL_REFRESH_INTERVAL) {
+        return RefreshMode::RFull;
+    }
+
+    if (changed_pixels * 100 > total_pixels * MAX_PARTIAL_PERCENT) {
+        return RefreshMode::RFull;
+    }
+
+    return RefreshMode::RPartial;
+}
+
+void RefreshPolicy::commit(RefreshMode mode) {
+    if (mode == RefreshMode::RFull) {
+        partial_count = 0;
+    } else if (mode == RefreshMode::RPartial) {
+        partial_count++;
+    }
+}
@@ -1,126 +1,244 @@
 #include <math.h>
+#include <string.h>
 #include <time.h>
 
 #include "weather.h"
+#include "civiltime.h"
 
 namespace WeatherAPI
 {
+#if WEATHER_JSON
   void parseCurrentWeather(DynamicJsonDocument &doc, Weather *weather)
   {
     unsigned long long current_weather_time = doc["currentWeather"]["time"].as<unsigned long long>();
     weather->current.time = static_cast<uint32_t>(current_weather_time / 1000);
     weather->current.icon = doc["currentWeather"]["icon"].as<unsigned char>();
-    weather->current.temperature = doc["currentWeather"]["temperature"].as<float>();
+    weather->current.setTemperature(doc["currentWeather"]["temperature"].as<float>());
   }
 
-  void parseForecasts(DynamicJsonDocument &doc, Weather *weather, time_t current_time)
+  void parseForecasts(DynamicJsonDocument &doc, Weather *weather, int days, time_t current_time)
   {  
-    struct tm current = *localtime(&current_time);
+    int32_t today = Civil::local(current_time).days;
 
-    char today_str[12];
-    strftime(today_str, sizeof(today_str), "%Y-%m-%d", &current);
+    weather->forecasts.start = static_cast<uint32_t>(Civil::floorLocal(current_time, SECONDS_PER_DAY));
+    weather->forecasts.step = STEP_DAY;
+    weather->forecasts.length = 0;
 
     JsonArray forecasts = doc["forecast"];
     
     bool started = false;
-    int i_forecast = 0;
     for(JsonObject f : forecasts) {
-      const char *date = f["dayDate"].as<char *>();
+      // stop when the horizon or the series is full
+      if (weather->forecasts.length >= days) break;
 
-      if (!started && strcmp(date, today_str) != 0) continue;
+      int32_t date;
+      if (!Civil::parseDate(f["dayDate"].as<const char *>(), &date)) continue;
+
+      if (!started && date != today) continue;
       started = true;
 
-      struct tm tm = {0};
-      strptime(date, "%Y-%m-%d", &tm);
-      uint8_t weekDay = static_cast<uint8_t>(tm.tm_wday) + 1; // 1 = sunday
+      uint8_t weekDay = static_cast<uint8_t>(Civil::weekday(date)) + 1; // 1 = sunday
 
       uint8_t icon = static_cast<uint8_t>(f["iconDay"].as<unsigned char>());
       float temperatureMax = f["temperatureMax"].as<float>();
       float temperatureMin = f["temperatureMin"].as<float>();
       float precipitation = f["precipitation"].as<float>();
 
-      WeatherForecast forecast = {.weekDay = weekDay, .icon = icon, .tempMax = temperatureMax, .tempMin = temperatureMin, .precipitation = precipitation};
-      weather->forecasts[i_forecast] = forecast;
-      i_forecast++;
+      WeatherForecast forecast = {0};
+      forecast.weekDay = weekDay;
+      forecast.icon = icon;
+      forecast.setTempMax(temperatureMax);
+      forecast.setTempMin(temperatureMin);
+      forecast.setPrecipitation(precipitation);
+      if (!weather->forecasts.set(weather->forecasts.length, forecast)) break;
+    }
+  }
+
+#endif
+
+  // index of the first element at or after from, of a series beginning at start
+  int seriesOffset(time_t start, int step, time_t from)
+  {
+    if (from <= start) return 0;
+    return (from - start + step - 1) / step;
+  }
 
-      if (i_forecast >= NUM_FORECASTS) break; // stop when forecasts array is full
+#if WEATHER_JSON
+  // copy up to length elements of a series beginning at from in fixed point (see quantize),
+  // out is cut to the elements there were
+  template <typename T, int CAPACITY>
+  void sliceSeries(JsonArray values, time_t start, int step, time_t from, int length, Series<T, CAPACITY> &out, float scale)
+  {
+    int first = seriesOffset(start, step, from);
+    int i = 0;
+
+    out.start = static_cast<uint32_t>(start + first * step);
+    out.step = step;
+    out.length = 0;
+
+    // elements are linked, walk to the first one instead of looking each up by index
+    for (JsonVariant value : values) {
+      if (out.length >= length) break;
+      if (i++ < first) continue;
+      if (!out.set(out.length, quantize<T>(value.as<float>(), scale))) break;
     }
   }
 
-  void parseGraph(DynamicJsonDocument &doc, Weather *weather, time_t current_time)
+  void parseGraph(DynamicJsonDocument &doc, Weather *weather, const Horizon &horizon, time_t current_time)
   {
-    JsonArray icons = doc["graph"]["weatherIcon3h"];
-    JsonArray temperatureMean1h = doc["graph"]["temperatureMean1h"];
-    JsonArray precipitation1h = doc["graph"]["precipitation1h"];
-    JsonArray precipitation10min = doc["graph"]["precipitation10m"];
-
-    // round to 
-    struct tm rounded = *localtime(&current_time);
-    rounded.tm_sec = 0;
-    rounded.tm_min = 0;
-    rounded.tm_hour -= rounded.tm_hour % 3; // round down to three hours
-    time_t rounded_time = mktime(&rounded);
+    JsonObject graph = doc["graph"];
+
+    // round down to three hours
+    time_t rounded_time = Civil::floorLocal(current_time, STEP_3H);
 
     // Graph
-    unsigned long long start_s = doc["graph"]["start"].as<unsigned long long>();
+    unsigned long long start_s = graph["start"].as<unsigned long long>();
     time_t start = static_cast<time_t>(start_s / 1000);
 
     // Start for low resolution (precipitation 1h)
-    unsigned long long start_l = doc["graph"]["startLowResolution"].as<unsigned long long>();
+    unsigned long long start_l = graph["startLowResolution"].as<unsigned long long>();
     time_t start_low = static_cast<time_t>(start_l / 1000);
-    
-    bool started = false;
-    for (int idx = 0, i_3h = 0; idx < NUM_3H && i_3h < icons.size(); i_3h++)
-    {
-      if (!started && start + i_3h * 10800 < rounded_time) continue;
-      started = true;
 
-      weather->icons[idx] = icons[i_3h].as<unsigned char>();
-      idx++;
+    sliceSeries(graph["weatherIcon3h"], start, STEP_3H, rounded_time, horizon.steps3h(), weather->icons, 1.f);
+    sliceSeries(graph["temperatureMean1h"], start, STEP_1H, rounded_time, horizon.steps1h(), weather->temperature_1h, SCALE_TEMPERATURE);
+    sliceSeries(graph["precipitation1h"], start_low, STEP_1H, rounded_time, horizon.steps1h(), weather->precipitation_1h, SCALE_PRECIPITATION);
+    sliceSeries(graph["precipitation10m"], start, STEP_10MIN, rounded_time, horizon.steps10min(), weather->precipitation_10min, SCALE_PRECIPITATION);
+
+    weather->start = rounded_time;
+  }
+
+  // only the fields parsed below are kept when deserializing (wind, sunrise, min / max series are dropped)
+  void buildFilter(JsonDocument &filter)
+  {
+    filter["currentWeather"]["time"] = true;
+    filter["currentWeather"]["icon"] = true;
+    filter["currentWeather"]["temperature"] = true;
+
+    JsonObject forecast = filter["forecast"].createNestedObject();
+    forecast["dayDate"] = true;
+    forecast["iconDay"] = true;
+    forecast["temperatureMax"] = true;
+    forecast["temperatureMin"] = true;
+    forecast["precipitation"] = true;
+
+    JsonObject graph = filter.createNestedObject("graph");
+    graph["start"] = true;
+    graph["startLowResolution"] = true;
+    graph["weatherIcon3h"] = true;
+    graph["temperatureMean1h"] = true;
+    graph["precipitation1h"] = true;
+    graph["precipitation10m"] = true;
+  }
+
+  bool parseWeather(DynamicJsonDocument &doc, Weather *weather, const Horizon &horizon, time_t current_time)
+  {
+    // assume weather was reset to {0}
+
+    parseCurrentWeather(doc, weather);
+    parseForecasts(doc, weather, horizon.days, current_time);
+    parseGraph(doc, weather, horizon, current_time);
+
+    return true;
+  }
+#endif
+
+  // little endian reader of the wire format, reading past the end sets overflow
+  struct WireReader {
+    const uint8_t *data;
+    size_t length;
+    size_t pos;
+    bool overflow;
+
+    uint32_t read(int bytes) {
+      if (pos + bytes > length) {
+        overflow = true;
+        return 0;
+      }
+      uint32_t value = 0;
+      for (int i = 0; i < bytes; i++) {
+        value |= static_cast<uint32_t>(data[pos++]) << (8 * i);
+      }
+      return value;
     }
 
-    started = false;
-    for (int idx = 0, i_1h = 0; idx < NUM_1H && i_1h < temperatureMean1h.size(); i_1h++)
-    {
-      if (!started && start + i_1h * 3600 < rounded_time) continue;
-      started = true;
+    uint8_t u8() { return static_cast<uint8_t>(read(1)); }
+    uint16_t u16() { return static_cast<uint16_t>(read(2)); }
+    int16_t i16() { return static_cast<int16_t>(read(2)); }
+    uint32_t u32() { return read(4); }
+  };
 
-      weather->temperatures[idx] = temperatureMean1h[i_1h].as<float>();
-      idx++;
+  // keep up to length elements from from on, same as sliceSeries
+  template <typename T, int CAPACITY>
+  void decodeSeries(WireReader &reader, int step, time_t from, int length, Series<T, CAPACITY> &out)
+  {
+    time_t start = reader.u32();
+    int count = reader.u8();
+    int first = seriesOffset(start, step, from);
+
+    out.start = static_cast<uint32_t>(start + first * step);
+    out.step = step;
+    out.length = 0;
+
+    for (int i = 0; i < count; i++) {
+      T value = static_cast<T>(reader.read(sizeof(T)));
+      if (i >= first && out.length < length) {
+        out.set(out.length, value);
+      }
     }
+  }
 
-    started = false;
-    for (int idx = 0, i_1h = 0; idx < NUM_1H && i_1h < precipitation1h.size(); i_1h++)
-    {
-      if (!started && start_low + i_1h * 3600 < rounded_time) continue;
-      started = true;
+  bool decodeWeather(const uint8_t *data, size_t length, Weather *weather, const Horizon &horizon, time_t current_time)
+  {
+    // assume weather was reset to {0}
+    WireReader reader = {data, length, 0, false};
+
+    if (length < 4 || memcmp(data, "WXB", 3) != 0 || data[3] != WIRE_VERSION) {
+      return false;
+    }
+    reader.pos = 4;
 
-      weather->precipitation1h[idx] = precipitation1h[i_1h].as<float>();
-      idx++;
+    weather->current.time = reader.u32();
+    weather->current.icon = reader.u8();
+    weather->current.temperature_value = reader.i16();
+
+    // current_time 0 takes the time of the response (built-in sample)
+    if (current_time == 0) {
+      current_time = weather->current.time;
     }
+    int32_t today = Civil::local(current_time).days;
+
+    weather->forecasts.start = static_cast<uint32_t>(Civil::floorLocal(current_time, SECONDS_PER_DAY));
+    weather->forecasts.step = STEP_DAY;
+    weather->forecasts.length = 0;
 
-    started = false;
-    for (int idx = 0, i_10min = 0; idx < NUM_10MIN && i_10min < precipitation10min.size(); i_10min++)
-    {
-      if (!started && start + i_10min * 600 < rounded_time) continue;
+    int num_forecasts = reader.u8();
+    bool started = false;
+    for (int i = 0; i < num_forecasts; i++) {
+      int32_t day = reader.u16();
+
+      WeatherForecast forecast = {0};
+      forecast.weekDay = static_cast<uint8_t>(Civil::weekday(day)) + 1; // 1 = sunday
+      forecast.icon = reader.u8();
+      forecast.temp_max = reader.i16();
+      forecast.temp_min = reader.i16();
+      forecast.precipitation_sum = reader.u16();
+
+      // from the entry of today on, as parseForecasts
+      if (!started && day != today) continue;
       started = true;
-    
-      weather->precipitation10min[idx] = precipitation10min[i_10min].as<float>();
-      idx++;
+      if (weather->forecasts.length >= horizon.days) continue;
+      weather->forecasts.set(weather->forecasts.length, forecast);
     }
 
-    weather->start = rounded_time;
-    weather->start_low = rounded_time > start_low ? rounded_time : start_low;
-  }
+    time_t rounded_time = Civil::floorLocal(current_time, STEP_3H);
 
-  bool parseWeather(DynamicJsonDocument &doc, Weather *weather, time_t current_time)
-  {
-    // assume weather was reset to {0}
+    decodeSeries(reader, STEP_3H, rounded_time, horizon.steps3h(), weather->icons);
+    decodeSeries(reader, STEP_1H, rounded_time, horizon.steps1h(), weather->temperature_1h);
+    decodeSeries(reader, STEP_1H, rounded_time, horizon.steps1h(), weather->precipitation_1h);
+    decodeSeries(reader, STEP_10MIN, rounded_time, horizon.steps10min(), weather->precipitation_10min);
 
-    parseCurrentWeather(doc, weather);
-    parseForecasts(doc, weather, current_time);
-    parseGraph(doc, weather, current_time);
+    weather->start = rounded_time;
 
-    return true;
+    return !reader.overflow && reader.pos == length;
   }
 }
\ No newline at end of file
@@ -0,0 +1,416 @@
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "weatherparser.h"
+
+// lexer states
+#define S_VALUE 0   // value expected
+#define S_KEY 1     // key or end of object expected
+#define S_COLON 2
+#define S_NEXT 3    // ',' or end of container expected
+#define S_STRING 4
+#define S_ESCAPE 5
+#define S_UNICODE 6 // 4 hex digits of \u
+#define S_BARE 7    // number or literal
+#define S_DONE 8
+
+struct FieldName {
+  uint8_t parent;
+  uint8_t field;
+  const char *name;
+};
+
+static const FieldName field_names[] = {
+  {FUnknown, FCurrentWeather, "currentWeather"},
+  {FUnknown, FForecast, "forecast"},
+  {FUnknown, FGraph, "graph"},
+  {FCurrentWeather, FTime, "time"},
+  {FCurrentWeather, FIcon, "icon"},
+  {FCurrentWeather, FTemperature, "temperature"},
+  {FForecast, FDayDate, "dayDate"},
+  {FForecast, FIconDay, "iconDay"},
+  {FForecast, FTemperatureMax, "temperatureMax"},
+  {FForecast, FTemperatureMin, "temperatureMin"},
+  {FForecast, FPrecipitation, "precipitation"},
+  {FGraph, FStart, "start"},
+  {FGraph, FStartLow, "startLowResolution"},
+  {FGraph, FIcon3h, "weatherIcon3h"},
+  {FGraph, FTemperatureMean1h, "temperatureMean1h"},
+  {FGraph, FPrecipitation1h, "precipitation1h"},
+  {FGraph, FPrecipitation10m, "precipitation10m"},
+};
+
+WeatherParser::WeatherParser(Weather *weather, const Horizon &horizon, time_t current_time) : weather(weather), horizon(horizon) {
+  state = S_VALUE;
+  token_length = 0;
+  token_overflow = false;
+  memset(&forecast, 0, sizeof(forecast));
+
+  if (current_time != 0) {
+    setTime(current_time);
+  }
+}
+
+void WeatherParser::setTime(time_t current_time) {
+  today = Civil::local(current_time).days;
+  rounded_time = Civil::floorLocal(current_time, STEP_3H); // round down to three hours
+  today_start = Civil::floorLocal(current_time, SECONDS_PER_DAY);
+}
+
+bool WeatherParser::fail(ParserError error) {
+  if (this->error == PNone) {
+    this->error = error;
+  }
+  return false;
+}
+
+bool WeatherParser::open(char container) {
+  if (depth >= PARSER_MAX_DEPTH) {
+    return fail(PDepth);
+  }
+
+  // a container inside an unknown field stays unknown
+  containers[depth] = container;
+  fields[depth] = FUnknown;
+  indices[depth] = 0;
+  depth++;
+
+  if (depth == 3 && containers[1] == '[' && fields[0] == FForecast) {
+    memset(&forecast, 0, sizeof(forecast));
+    forecast_today = false;
+  }
+
+  state = container == '{' ? S_KEY : S_VALUE;
+  return true;
+}
+
+bool WeatherParser::close(char container) {
+  if (depth == 0 || containers[depth - 1] != container) {
+    return fail(PSyntax);
+  }
+  depth--;
+
+  // end of a forecast day, keep it from today on
+  if (depth == 2 && container == '{' && containers[1] == '[' && fields[0] == FForecast) {
+    forecast_started = forecast_started || forecast_today;
+    if (forecast_started && weather->forecasts.length < horizon.days) {
+      weather->forecasts.set(weather->forecasts.length, forecast);
+    }
+  }
+
+  state = depth == 0 ? S_DONE : S_NEXT;
+  return true;
+}
+
+// field id of a key within its parent section
+static uint8_t lookup(uint8_t parent, const char *name) {
+  for (unsigned int i = 0; i < sizeof(field_names) / sizeof(field_names[0]); i++) {
+    if (field_names[i].parent == parent && strcmp(field_names[i].name, name) == 0) {
+      return field_names[i].field;
+    }
+  }
+  return FUnknown;
+}
+
+bool WeatherParser::key() {
+  // only keys of the root and of known sections are looked up
+  uint8_t parent = FUnknown;
+  if (depth == 2) {
+    parent = fields[0];
+  } else if (depth == 3 && containers[1] == '[' && fields[0] == FForecast) {
+    parent = FForecast;
+  }
+
+  bool known = depth == 1 || parent != FUnknown;
+  fields[depth - 1] = known && !token_overflow ? lookup(parent, token) : (uint8_t)FUnknown;
+  return true;
+}
+
+bool WeatherParser::endToken() {
+  token[token_length] = 0;
+
+  if (is_key) {
+    state = S_COLON;
+    return key();
+  }
+
+  bool is_string = state == S_STRING;
+  state = S_NEXT;
+  return value(is_string);
+}
+
+bool WeatherParser::value(bool is_string) {
+  // section and field this value belongs to, and its position in a series
+  uint8_t section = FUnknown, field = FUnknown;
+  int index = -1;
+  if (depth == 2 && containers[1] == '{') {
+    // currentWeather.time, graph.start
+    section = fields[0];
+    field = fields[1];
+  } else if (depth == 3 && containers[1] == '[' && containers[2] == '{') {
+    // forecast[i].dayDate
+    section = fields[0];
+    field = fields[2];
+  } else if (depth == 3 && containers[1] == '{' && containers[2] == '[') {
+    // graph.temperatureMean1h[i]
+    section = fields[0];
+    field = fields[1];
+    index = indices[2];
+  }
+
+  if (!is_string) {
+    // validate bare tokens even if they are not used
+    if (strcmp(token, "true") != 0 && strcmp(token, "false") != 0 && strcmp(token, "null") != 0) {
+      char *end;
+      strtod(token, &end);
+      if (token_length == 0 || *end != 0) {
+        return fail(PSyntax);
+      }
+    }
+  }
+
+  if (field == FUnknown) {
+    return true;
+  }
+  if (token_overflow) {
+    return fail(PToken);
+  }
+
+  if (section == FCurrentWeather && depth == 2) {
+    if (field == FTime) {
+      weather->current.time = static_cast<uint32_t>(strtoull(token, NULL, 10) / 1000);
+      has_current = true;
+      if (rounded_time == 0) {
+        setTime(weather->current.time);
+      }
+    } else if (field == FIcon) {
+      weather->current.icon = static_cast<uint8_t>(atoi(token));
+    } else if (field == FTemperature) {
+      weather->current.setTemperature(strtof(token, NULL));
+    }
+  } else if (section == FForecast && depth == 3) {
+    if (field == FDayDate) {
+      int32_t date;
+      if (!Civil::parseDate(token, &date)) {
+        return fail(PSchema);
+      }
+      forecast_today = date == today;
+      forecast.weekDay = static_cast<uint8_t>(Civil::weekday(date)) + 1; // 1 = sunday
+    } else if (field == FIconDay) {
+      forecast.icon = static_cast<uint8_t>(atoi(token));
+    } else if (field == FTemperatureMax) {
+      forecast.setTempMax(strtof(token, NULL));
+    } else if (field == FTemperatureMin) {
+      forecast.setTempMin(strtof(token, NULL));
+    } else if (field == FPrecipitation) {
+      forecast.setPrecipitation(strtof(token, NULL));
+    }
+  } else if (section == FGraph && depth == 2) {
+    if (field == FStart) {
+      start = static_cast<uint32_t>(strtoull(token, NULL, 10) / 1000);
+    } else if (field == FStartLow) {
+      start_low = static_cast<uint32_t>(strtoull(token, NULL, 10) / 1000);
+    }
+  } else if (section == FGraph && depth == 3 && index >= 0) {
+    if (start == 0 || start_low == 0 || rounded_time == 0) {
+      return fail(PSchema);
+    }
+    seriesValue((ParserField)field, index, strtof(token, NULL));
+  }
+
+  return true;
+}
+
+// store element index of a series if it falls into the window from rounded_time on
+void WeatherParser::seriesValue(ParserField field, int index, float value) {
+  time_t series_start = field == FPrecipitation1h ? start_low : start;
+  int step = field == FIcon3h ? STEP_3H : field == FPrecipitation10m ? STEP_10MIN : STEP_1H;
+
+  int i = index - WeatherAPI::seriesOffset(series_start, step, rounded_time);
+  if (i < 0) return;
+
+  // elements past the horizon or the capacity of the series are dropped
+  if (field == FIcon3h && i < horizon.steps3h()) {
+    weather->icons.set(i, quantize<uint8_t>(value, 1.f));
+  } else if (field == FTemperatureMean1h && i < horizon.steps1h()) {
+    weather->temperature_1h.set(i, quantize<int16_t>(value, SCALE_TEMPERATURE));
+  } else if (field == FPrecipitation1h && i < horizon.steps1h()) {
+    weather->precipitation_1h.set(i, quantize<uint8_t>(value, SCALE_PRECIPITATION));
+  } else if (field == FPrecipitation10m && i < horizon.steps10min()) {
+    weather->precipitation_10min.set(i, quantize<uint8_t>(value, SCALE_PRECIPITATION));
+  }
+}
+
+// time of the first element kept of a series beginning at series_start
+template <typename T, int CAPACITY>
+void WeatherParser::setSeries(Series<T, CAPACITY> &series, time_t series_start, int step) {
+  series.start = series_start + WeatherAPI::seriesOffset(series_start, step, rounded_time) * step;
+  series.step = step;
+}
+
+bool WeatherParser::feed(char c) {
+  if (error != PNone) {
+    return false;
+  }
+
+  switch (state) {
+    case S_STRING:
+      if (c == '"') return endToken();
+      if (c == '\\') {
+        state = S_ESCAPE;
+        return true;
+      }
+      if ((unsigned char)c < 0x20) return fail(PSyntax);
+      break;
+
+    case S_ESCAPE:
+      if (c == 'u') {
+        // none of the used values needs it, the character is replaced
+        state = S_UNICODE;
+        unicode_digits = 0;
+        c = '?';
+        break;
+      }
+      if (strchr("\"\\/bfnrt", c) == NULL) return fail(PSyntax);
+      state = S_STRING;
+      break;
+
+    case S_UNICODE:
+      if (!isxdigit(c)) return fail(PSyntax);
+      if (++unicode_digits == 4) state = S_STRING;
+      return true;
+
+    case S_BARE:
+      if (isalnum(c) || c == '-' || c == '+' || c == '.') break;
+      if (!endToken()) return false;
+      return feed(c);
+
+    default:
+      if (c == ' ' || c == '\t' || c == '\n' || c == '\r') return true;
+
+      if (state == S_DONE) return fail(PSyntax);
+
+      if (state == S_COLON) {
+        if (c != ':') return fail(PSyntax);
+        state = S_VALUE;
+        return true;
+      }
+
+      if (state == S_NEXT) {
+        if (c == '}' || c == ']') return close(c == '}' ? '{' : '[');
+        if (c != ',') return fail(PSyntax);
+        indices[depth - 1]++;
+        state = containers[depth - 1] == '[' ? S_VALUE : S_KEY;
+        return true;
+      }
+
+      if (state == S_KEY) {
+        if (c == '}' && indices[depth - 1] == 0) return close('{');
+        if (c != '"') return fail(PSyntax);
+        is_key = true;
+        token_length = 0;
+        token_overflow = false;
+        state = S_STRING;
+        return true;
+      }
+
+      // S_VALUE
+      if (c == '{' || c == '[') return open(c);
+      if (c == ']' && depth > 0 && containers[depth - 1] == '[' && indices[depth - 1] == 0) return close('[');
+      if (depth == 0) return fail(PSyntax); // the response is an object
+
+      is_key = false;
+      token_length = 0;
+      token_overflow = false;
+      if (c == '"') {
+        state = S_STRING;
+        return true;
+      }
+      if (!isalnum(c) && c != '-') return fail(PSyntax);
+      state = S_BARE;
+      break;
+  }
+
+  // append to the token, long values are only a problem for known fields
+  if (token_length < PARSER_MAX_TOKEN - 1) {
+    token[token_length++] = c;
+  } else {
+    token_overflow = true;
+  }
+  return true;
+}
+
+bool WeatherParser::done() {
+  return state == S_DONE || error != PNone;
+}
+
+bool WeatherParser::finish() {
+  if (error != PNone) {
+    return false;
+  }
+  if (state != S_DONE) {
+    return fail(PIncomplete);
+  }
+  if (!has_current || start == 0 || start_low == 0) {
+    return fail(PSchema);
+  }
+
+  weather->start = rounded_time;
+  setSeries(weather->icons, start, STEP_3H);
+  setSeries(weather->temperature_1h, start, STEP_1H);
+  setSeries(weather->precipitation_1h, start_low, STEP_1H);
+  setSeries(weather->precipitation_10min, start, STEP_10MIN);
+  weather->forecasts.start = today_start;
+  weather->forecasts.step = STEP_DAY;
+  return true;
+}
+
+bool WeatherParser::parse(Client &client) {
+  uint8_t buffer[64];
+  unsigned long last = millis();
+
+  while (!done()) {
+    int available = client.available();
+    if (available <= 0) {
+      if (!client.connected() || millis() - last > PARSER_TIMEOUT) break;
+      delay(1);
+      continue;
+    }
+
+    int length = client.read(buffer, available < (int)sizeof(buffer) ? available : sizeof(buffer));
+    if (length < 0) break;
+    // only data restarts the timeout, also when available() reports bytes read() does not deliver
+    if (length == 0) {
+      if (millis() - last > PARSER_TIMEOUT) break;
+      delay(1);
+      continue;
+    }
+    for (int i = 0; i < length && feed(buffer[i]); i++);
+    last = millis();
+  }
+
+  return finish();
+}
+
+bool WeatherParser::parse(const char *json) {
+  for (const char *p = json; !done(); p++) {
+    char c = pgm_read_byte(p);
+    if (c == 0) break;
+    feed(c);
+  }
+
+  return finish();
+}
+
+const char *WeatherParser::errorString() {
+  switch (error) {
+    case PNone: return "Ok";
+    case PSyntax: return "InvalidInput";
+    case PDepth: return "TooDeep";
+    case PToken: return "TokenTooLong";
+    case PSchema: return "UnexpectedSchema";
+    case PIncomplete: return "IncompleteInput";
+  }
+  return "Unknown";
+}
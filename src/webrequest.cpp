@@ -1,8 +1,109 @@
+#include <time.h>
+#include <tcpip_adapter.h>
+#include <lwip/netif.h>
+#include <lwip/dhcp.h>
+
 #include "webrequest.h"
 #include "wifi_login.h"
 
 #define NUM_TRIES 4
-#define WAIT_TIME 5
+#define WAIT_TIME 5 // s per try to associate
+#define WIFI_DHCP_TIMEOUT 5000 // ms for the address from DHCP
+#define WIFI_STATIC_TIMEOUT 500 // ms for the address of the cached lease
+
+#ifndef SERVER_PORT
+#define SERVER_PORT 443
+#endif
+
+#ifdef SERVER_CA_DER
+static const uint8_t server_ca[] = SERVER_CA_DER;
+#endif
+
+WebRequest::WebRequest() {
+  client.setMaxFragmentLength(TLS_MAX_FRAGMENT);
+#ifdef SERVER_PSK
+  // the proxy on the LAN knows the key, certificates are not involved
+  setPreSharedKey(SERVER_PSK_IDENTITY, SERVER_PSK);
+#else
+#ifdef SERVER_CA_DER
+  setTrustAnchor(server_ca, sizeof(server_ca));
+#endif
+#ifdef SERVER_PIN
+  setServerPin(SERVER_PIN);
+#endif
+#endif
+}
+
+// wait on the event bits of the WiFi driver: association, then the address, each with its deadline
+bool WebRequest::waitConnected(unsigned long associate, unsigned long address) {
+  if (!WiFi.waitStatusBits(STA_CONNECTED_BIT, associate)) {
+    return false;
+  }
+  return WiFi.waitStatusBits(STA_HAS_IP_BIT, address) != 0;
+}
+
+// lease time of the last DHCP answer on the station interface (option 51), 0 if there is none
+static uint32_t leaseTime() {
+  struct netif *netif = nullptr;
+  if (tcpip_adapter_get_netif(TCPIP_ADAPTER_IF_STA, (void **)&netif) != ESP_OK || netif == nullptr) {
+    return 0;
+  }
+  struct dhcp *dhcp = netif_dhcp_data(netif);
+  return dhcp != nullptr ? dhcp->offered_t0_lease : 0;
+}
+
+// straight to the access point of the last wake, without a scan, and on its lease while that is fresh
+bool WebRequest::connectCached() {
+  if (!wifi_cache || !wifi_cache->valid) {
+    return false;
+  }
+
+  // the clock runs through deep sleep. The lease is used until half of it has passed, when a DHCP
+  // client would renew it (T1). A clock set by SNTP since then or an unknown lease asks DHCP again
+  uint32_t now = time(NULL);
+  bool lease = now >= wifi_cache->obtained && now - wifi_cache->obtained < (wifi_cache->expires - wifi_cache->obtained) / 2;
+  if (lease) {
+    WiFi.config(IPAddress(wifi_cache->ip), IPAddress(wifi_cache->gateway), IPAddress(wifi_cache->subnet),
+                IPAddress(wifi_cache->dns1), IPAddress(wifi_cache->dns2));
+  }
+  WiFi.begin(ssid, password, wifi_cache->channel, wifi_cache->bssid);
+
+  if (waitConnected(WIFI_FAST_TIMEOUT, lease ? WIFI_STATIC_TIMEOUT : WIFI_DHCP_TIMEOUT)) {
+    saveCache(!lease);
+    return true;
+  }
+
+  // access point moved or gone: scan and ask DHCP as usual
+  Serial.println("Cached access point failed");
+  wifi_cache->valid = false;
+  WiFi.disconnect();
+  if (lease) {
+    WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+  }
+  return false;
+}
+
+// access point of this connect, the lease too if it came from DHCP
+void WebRequest::saveCache(bool dhcp) {
+  if (!wifi_cache) {
+    return;
+  }
+  memcpy(wifi_cache->bssid, WiFi.BSSID(), sizeof(wifi_cache->bssid));
+  wifi_cache->channel = WiFi.channel();
+  if (dhcp) {
+    wifi_cache->ip = WiFi.localIP();
+    wifi_cache->gateway = WiFi.gatewayIP();
+    wifi_cache->subnet = WiFi.subnetMask();
+    wifi_cache->dns1 = WiFi.dnsIP(0);
+    wifi_cache->dns2 = WiFi.dnsIP(1);
+
+    uint32_t now = time(NULL);
+    uint32_t lease = leaseTime();
+    wifi_cache->obtained = now;
+    wifi_cache->expires = lease > UINT32_MAX - now ? UINT32_MAX : now + lease; // infinite lease: 0xffffffff
+  }
+  wifi_cache->valid = true;
+}
 
 bool WebRequest::connect() {
 
@@ -12,27 +113,35 @@ bool WebRequest::connect() {
 
   Serial.print("Attempting to connect to SSID: ");
   Serial.println(ssid);
-  
-  for(int num_tries = 0; num_tries < NUM_TRIES * WAIT_TIME; num_tries++) {
-    
-    if (num_tries % WAIT_TIME == 0) {
-      WiFi.begin(ssid, password);
-    }
 
-    Serial.print(".");
-    delay(1000);
+  // the station config does not need to go to flash on every wake
+  WiFi.persistent(false);
+  WiFi.mode(WIFI_STA);
 
-    if (WiFi.status() == WL_CONNECTED) {
-      Serial.print("Connected to ");
-      Serial.println(ssid);
-
-      connected = true;
-      return true;
+  unsigned long start = millis();
+  bool success = connectCached();
+  for (int num_tries = 0; !success && num_tries < NUM_TRIES; num_tries++) {
+    Serial.print(".");
+    WiFi.begin(ssid, password);
+    if (waitConnected(WAIT_TIME * 1000, WIFI_DHCP_TIMEOUT)) {
+      saveCache(true);
+      success = true;
     }
   }
-  
-  Serial.println("Could not connect to WiFi");
-  return false;
+
+  if (!success) {
+    Serial.println("Could not connect to WiFi");
+    return false;
+  }
+
+  Serial.print("Connected to ");
+  Serial.print(ssid);
+  Serial.print(" in ");
+  Serial.print(millis() - start);
+  Serial.println(" ms");
+
+  connected = true;
+  return true;
 }
 
 bool WebRequest::requestWeather() {
@@ -40,31 +149,145 @@ bool WebRequest::requestWeather() {
     return false;
   }
 
+  // resolved on its own (the driver waits on its DNS event bits), the TLS connect then finds it in the lwIP cache
+  unsigned long start = millis();
+  IPAddress address;
+  if (!WiFi.hostByName(server, address)) {
+    Serial.println("DNS lookup failed!");
+    return false;
+  }
+  Serial.print("Resolved server in ");
+  Serial.print(millis() - start);
+  Serial.println(" ms");
+
   Serial.println("\nStarting connection to server...");
-  if (!client.connect(server, 443)) {
+  heap_before = ESP.getFreeHeap();
+  if (!stream.connect(server, SERVER_PORT)) {
     Serial.println("Connection failed!");
     return false;
   }
   
   Serial.println("Connected to server!");
 
-  // Make a HTTP request:
-  client.println(headers);
-  client.println();
+  // the request as one write, println per line would give a TLS record each
+  HttpRequest request;
+  request.begin(headers, server);
+#if USE_COMPRESSION
+  request.header("Accept-Encoding", "gzip, deflate");
+#endif
+  if (conditional) {
+    request.conditional(*conditional);
+  }
+  if (!request.send(stream)) {
+    Serial.println("Sending request failed!");
+    stream.stop();
+    return false;
+  }
 
   Serial.println("Sent request!");
 
-  while (client.connected()) {
-    String line = client.readStringUntil('\n');
-    // Serial.println(line);
-    if (line == "\r") {
-      Serial.println("headers received");
-      return true;
+  if (!readResponseHead(stream, response, HTTP_HEAD_TIMEOUT)) {
+    Serial.println("Timeout - No headers");
+    stream.stop();
+    return false;
+  }
+
+  Serial.print("HTTP status: ");
+  Serial.println(response.status);
+  if (notModified()) {
+    // nothing to read, close the TLS session right away
+    Serial.println("Not modified");
+    stream.stop();
+    return false;
+  }
+  if (response.status < 200 || response.status >= 300) {
+    stream.stop();
+    return false;
+  }
+
+  body.begin(stream, response);
+  body.setTimeout(HTTP_BODY_TIMEOUT);
+
+  if (response.encoding == HUnsupported) {
+    Serial.println("Unsupported Content-Encoding");
+    stream.stop();
+    return false;
+  }
+  if (response.encoding != HIdentity) {
+    // window and decompressor only for the time of this response
+    if (!inflate.begin(body, response.encoding == HGzip ? IGzip : IZlib)) {
+      Serial.println("No memory to inflate");
+      stream.stop();
+      return false;
     }
+    inflate.setTimeout(HTTP_BODY_TIMEOUT);
   }
-  
-  Serial.println("Timeout - No headers");
-  return false;
+  return true;
+}
+
+Client &WebRequest::content() {
+  if (response.encoding == HIdentity) {
+    return body;
+  }
+  return inflate;
+}
+
+// read the whole body, -1 if it does not fit into buffer or is cut off
+int WebRequest::readBody(uint8_t *buffer, size_t size) {
+  if (response.encoding == HIdentity && response.framing == HLength && response.content_length > (long)size) {
+    Serial.println("Response too large");
+    return -1;
+  }
+
+  size_t length = 0;
+  unsigned long last = millis();
+
+  Client &reader = content();
+  while (reader.connected()) {
+    int available = reader.available();
+    if (available <= 0) {
+      if (millis() - last > HTTP_BODY_TIMEOUT) break;
+      delay(1);
+      continue;
+    }
+    if (length >= size) {
+      Serial.println("Response too large");
+      return -1;
+    }
+
+    int read = reader.read(buffer + length, size - length);
+    if (read > 0) {
+      length += read;
+      last = millis();
+    }
+  }
+  bool done = response.encoding == HIdentity ? body.done() : inflate.done();
+  if (!done) {
+    Serial.println("Response incomplete");
+    return -1;
+  }
+  return length;
+}
+
+// how the response was read: bytes, calls of the parser, bulk reads of the TLS client and heap
+void WebRequest::printStatistics() {
+  Serial.print("Response bytes: ");
+  Serial.print(stream.bytes);
+  Serial.print(", reads: ");
+  Serial.print(stream.calls);
+  Serial.print(", TLS reads: ");
+  Serial.print(stream.fills);
+  Serial.print(", inflated: ");
+  Serial.println(response.encoding == HIdentity ? 0 : inflate.inflated());
+
+  // the low mark is kept since boot, nothing before the request needs as much as the handshake
+  uint32_t lowest = ESP.getMinFreeHeap();
+  Serial.print("Heap before TLS: ");
+  Serial.print(heap_before);
+  Serial.print(", lowest: ");
+  Serial.print(lowest);
+  Serial.print(", peak use: ");
+  Serial.println(heap_before > lowest ? heap_before - lowest : 0);
 }
 
 void WebRequest::disconnect() {
@@ -73,6 +296,7 @@ void WebRequest::disconnect() {
     return;
   }
   client.stop();
+  inflate.end();
 
   WiFi.disconnect(true);
   WiFi.mode(WIFI_OFF);